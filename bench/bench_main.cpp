@@ -0,0 +1,553 @@
+// Host benchmark for the ANT+ frame parser and the FTMS Indoor Bike Data encoder.
+//
+//   pio run -e native && .pio/build/native/program [frames] [capture.bin] [--max-ns N]
+//
+// The parser is measured on the UART path (readSerial, legacy frames and link v2
+// packets) and the /ws path (readWebSocket).
+//   .pio/build/native/program stress [seconds]     (see seqlock_stress.cpp)
+//   .pio/build/native/program replay | convert ... (see capture_tools.cpp)
+//
+// Frames are `0xA4 | deviceType | len | payload | xor`, replayed through the Serial
+// shim in UART-sized bursts and the SerialIngest ring, as on the device. Without a
+// capture file (raw frames, or a .acap capture from the recorder or the converter)
+// a synthetic ride (FE, power meter and common pages, as forwarded by
+// DeviceScanner/scanner.py) is generated.
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <vector>
+#include "ant_capture.h"
+#include "ant_parser.h"
+#include "ble_ftms.h"
+#include "fit_export.h"
+#include "ride_format.h"
+#include "serial_ingest.h"
+#include "serial_link_v2.h"
+#include "websocket_ingest.h"
+
+#define DEFAULT_FRAME_COUNT 2000000UL
+#define DEFAULT_STRESS_SECONDS 2
+#define UART_BURST_BYTES 256  // Bytes handed to readSerial() per pass, roughly one UART FIFO drain
+#define WS_BATCH_BYTES 1024   // One /ws message from the Pi forwarder, ~85 frames
+#define LINK_V2_BATCH_FRAMES 8  // Messages per serial link v2 packet: one multi-sensor burst
+#define RIDE_BENCH_SECONDS (3 * 3600)  // A three-hour ride for the ride format sections
+#define FIT_CHUNK_BYTES 1436  // One chunked HTTP response callback: a TCP segment less the chunk framing
+
+// ✅ Count every heap allocation made while a benchmark section runs
+static unsigned long allocationCount = 0;
+
+void *operator new(size_t size) {
+    allocationCount++;
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+int runSeqlockStress(unsigned seconds);
+int runReplay(const char *path, double speed);
+int runConvert(const char *outPath, int inputCount, char **inputs);
+bool readFile(std::vector<uint8_t> &out, const char *path);
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void appendFrame(std::vector<uint8_t> &out, uint8_t deviceType, const uint8_t *payload, uint8_t len) {
+    uint8_t crc = 0;
+    out.push_back(0xA4);
+    out.push_back(deviceType);
+    out.push_back(len);
+    for (uint8_t i = 0; i < len; i++) {
+        out.push_back(payload[i]);
+        crc ^= payload[i];
+    }
+    out.push_back(crc);
+}
+
+// ✅ Synthetic ride: mostly FE trainer/general pages and power meter pages, with the
+// occasional common page, in the ratio a trainer plus power meter broadcast them
+static size_t buildSyntheticCapture(std::vector<uint8_t> &out, unsigned long frames) {
+    out.reserve(frames * 12);
+    for (unsigned long i = 0; i < frames; i++) {
+        uint8_t t = i & 0xFF;
+        uint16_t power = 150 + (i % 200);
+        uint8_t payload[8];
+
+        switch (i % 8) {
+            case 0: case 4: {  // FE Trainer Data (0x19)
+                uint8_t p[8] = {0x19, t, (uint8_t)(80 + i % 20), (uint8_t)(i * 3), (uint8_t)(i >> 5),
+                                (uint8_t)(power & 0xFF), (uint8_t)((power >> 8) & 0x0F), 0x30};
+                memcpy(payload, p, 8);
+                appendFrame(out, (uint8_t)DeviceType::FitnessEquipment, payload, 8);
+                break;
+            }
+            case 1: case 5: {  // Power Meter Main Data (0x10)
+                uint8_t p[8] = {0x10, t, 0xFF, (uint8_t)(85 + i % 10), (uint8_t)(i * 7), (uint8_t)(i >> 4),
+                                (uint8_t)(power & 0xFF), (uint8_t)(power >> 8)};
+                memcpy(payload, p, 8);
+                appendFrame(out, (uint8_t)DeviceType::PowerMeter, payload, 8);
+                break;
+            }
+            case 2: case 6: {  // FE General Data (0x10)
+                uint16_t speed = 8000 + (i % 1000);
+                uint8_t p[8] = {0x10, 0x19, t, (uint8_t)(i >> 2), (uint8_t)(speed & 0xFF), (uint8_t)(speed >> 8), 0xFF, 0x30};
+                memcpy(payload, p, 8);
+                appendFrame(out, (uint8_t)DeviceType::FitnessEquipment, payload, 8);
+                break;
+            }
+            case 3: {  // FE Trainer Status (0x11)
+                uint8_t p[8] = {0x11, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x28, 0x30};
+                memcpy(payload, p, 8);
+                appendFrame(out, (uint8_t)DeviceType::FitnessEquipment, payload, 8);
+                break;
+            }
+            default: {  // Common pages 0x50 / 0x51
+                uint8_t p50[8] = {0x50, 0xFF, 0xFF, 0x01, 0x59, 0x00, 0x24, 0x01};
+                uint8_t p51[8] = {0x51, 0xFF, 0x05, 0x0A, 0x78, 0x56, 0x34, 0x12};
+                memcpy(payload, (i & 8) ? p50 : p51, 8);
+                appendFrame(out, (uint8_t)DeviceType::FitnessEquipment, payload, 8);
+                break;
+            }
+        }
+    }
+    return frames;
+}
+
+// ✅ Load a capture and count how many frames it holds. A binary capture is unpacked
+// to the frames alone, back to back, as they'd arrive on the wire.
+static size_t loadCapture(std::vector<uint8_t> &out, const char *path) {
+    if (!readFile(out, path)) {
+        fprintf(stderr, "Cannot open capture %s\n", path);
+        exit(1);
+    }
+
+    size_t frames = 0;
+    if (CaptureReader::isCapture(out.data(), out.size())) {
+        std::vector<uint8_t> file;
+        file.swap(out);
+        CaptureReader reader;
+        CaptureRecord record;
+        if (!reader.open(file.data(), file.size())) return 0;
+        while (reader.next(record)) {
+            out.insert(out.end(), record.frame, record.frame + record.length);
+            frames++;
+        }
+        return frames;
+    }
+
+    for (size_t pos = 0; pos + 3 < out.size();) {
+        if (out[pos] != 0xA4 && out[pos] != 0xF0) { pos++; continue; }
+        pos += out[pos + 2] + 4;
+        frames++;
+    }
+    return frames;
+}
+
+struct BenchResult {
+    double nsPerItem;
+    double bytesPerSec;
+    double allocsPerItem;
+};
+
+static void report(const char *name, const BenchResult &r) {
+    printf("%-24s %10.1f ns/frame %10.2f MB/s %8.3f allocs/frame\n",
+           name, r.nsPerItem, r.bytesPerSec / 1e6, r.allocsPerItem);
+}
+
+static BenchResult benchParser(ANTParser &parser, const std::vector<uint8_t> &capture, size_t frames) {
+    unsigned long allocsBefore = allocationCount;
+    uint64_t start = nowNs();
+
+    for (size_t pos = 0; pos < capture.size(); pos += UART_BURST_BYTES) {
+        size_t len = capture.size() - pos < UART_BURST_BYTES ? capture.size() - pos : UART_BURST_BYTES;
+        Serial.feed(capture.data() + pos, len);
+        parser.readSerial();
+    }
+
+    uint64_t elapsed = nowNs() - start;
+    BenchResult r;
+    r.nsPerItem = (double)elapsed / frames;
+    r.bytesPerSec = capture.size() * 1e9 / elapsed;
+    r.allocsPerItem = (double)(allocationCount - allocsBefore) / frames;
+    return r;
+}
+
+// ✅ Same capture as binary /ws messages: WebSocketIngest ring, then readWebSocket().
+// Messages end mid-frame, as a forwarder batching by size would send them.
+static BenchResult benchWebSocket(ANTParser &parser, const std::vector<uint8_t> &capture, size_t frames) {
+    unsigned long allocsBefore = allocationCount;
+    uint64_t start = nowNs();
+
+    for (size_t pos = 0; pos < capture.size(); pos += WS_BATCH_BYTES) {
+        size_t len = capture.size() - pos < WS_BATCH_BYTES ? capture.size() - pos : WS_BATCH_BYTES;
+        wsIngest.write(capture.data() + pos, len);
+        parser.readWebSocket();
+    }
+
+    uint64_t elapsed = nowNs() - start;
+    BenchResult r;
+    r.nsPerItem = (double)elapsed / frames;
+    r.bytesPerSec = capture.size() * 1e9 / elapsed;
+    r.allocsPerItem = (double)(allocationCount - allocsBefore) / frames;
+    return r;
+}
+
+// ✅ Re-frame a legacy capture as serial link v2 packets of up to `batch` messages
+static size_t buildLinkV2Capture(std::vector<uint8_t> &out, const std::vector<uint8_t> &capture, uint8_t batch) {
+    SerialLinkV2Encoder encoder;
+    uint8_t wire[LINK_V2_MAX_WIRE_BYTES];
+    uint8_t sequence = 0;
+    size_t packets = 0;
+    encoder.begin(sequence);
+
+    auto flush = [&]() {
+        size_t n = encoder.finish(wire);
+        out.insert(out.end(), wire, wire + n);
+        encoder.begin(++sequence);
+        packets++;
+    };
+
+    for (size_t pos = 0; pos + 3 < capture.size();) {
+        const uint8_t *frame = capture.data() + pos;
+        if (frame[0] != ANT_SYNC_BYTE && frame[0] != CMD_SYNC_BYTE) { pos++; continue; }
+        if (pos + frame[2] + ANT_FRAME_OVERHEAD > capture.size()) break;
+        if (!encoder.add(frame[0], frame[1], frame + 3, frame[2])) {
+            flush();
+            encoder.add(frame[0], frame[1], frame + 3, frame[2]);
+        }
+        if (encoder.getMessages() == batch) flush();
+        pos += frame[2] + ANT_FRAME_OVERHEAD;
+    }
+    if (encoder.getMessages()) flush();
+    return packets;
+}
+
+// ✅ Synthetic 1 Hz ride: power, cadence and speed wandering around a steady effort,
+// heart rate drifting up, a few stops (gaps in the seconds), totals integrated
+static void buildSyntheticRide(std::vector<RideSample> &out, uint32_t seconds) {
+    uint32_t seed = 12345;
+    auto noise = [&](int range) {
+        seed = seed * 1103515245 + 12345;
+        return (int)((seed >> 16) % (2 * range + 1)) - range;
+    };
+
+    RideSample sample = {};
+    sample.unixTime = 1760000000;
+    double distance = 0, energy = 0;
+    for (uint32_t t = 0; t < seconds; t++) {
+        if (t % 1800 == 1799) t += 60 + noise(30);  // A stop every half hour
+        sample.second = t;
+        sample.unixTime = 1760000000 + t;
+        sample.power = 200 + noise(25) + (t % 600 < 60 ? 150 : 0);
+        sample.cadence = 88 + noise(3);
+        sample.speed = 3000 + noise(40);
+        sample.heartRate = 130 + t / 300 % 30 + noise(1);
+        distance += sample.speed / 360000.0;
+        energy += sample.power;
+        sample.distance = (uint32_t)distance;
+        sample.energy = (uint32_t)energy;
+        out.push_back(sample);
+    }
+}
+
+static size_t writeRideFile(std::vector<uint8_t> &file, const std::vector<RideSample> &ride) {
+    RideBlockWriter writer;
+    uint8_t block[RIDE_BLOCK_BYTES];
+    file.resize(RIDE_FILE_HEADER_BYTES);
+    ride_write_file_header(file.data());
+    size_t payload = 0;
+    RideSummary summary;
+
+    auto flush = [&]() {
+        payload += writer.getPayloadBytes();
+        writer.summarize(summary);
+        size_t n = writer.finish(block);
+        file.insert(file.end(), block, block + n);
+    };
+    for (const RideSample &sample : ride) {
+        if (!writer.add(sample)) {
+            flush();
+            writer.add(sample);
+        }
+    }
+    flush();
+    ride_write_summary(block, summary);
+    file.insert(file.end(), block, block + RIDE_BLOCK_BYTES);
+    return payload;
+}
+
+struct MemoryReader {
+    const std::vector<uint8_t> *data;
+    size_t pos;
+};
+
+static size_t readMemory(void *context, uint8_t *out, size_t len) {
+    MemoryReader &reader = *static_cast<MemoryReader *>(context);
+    size_t n = std::min(len, reader.data->size() - reader.pos);
+    memcpy(out, reader.data->data() + reader.pos, n);
+    reader.pos += n;
+    return n;
+}
+
+static bool sameSample(const RideSample &a, const RideSample &b) {
+    return a.second == b.second && a.unixTime == b.unixTime && a.power == b.power && a.cadence == b.cadence &&
+           a.speed == b.speed && a.heartRate == b.heartRate && a.distance == b.distance && a.energy == b.energy;
+}
+
+// ✅ The ride recorder's encode path: samples into blocks into a file image
+static BenchResult benchRideEncode(const std::vector<RideSample> &ride, std::vector<uint8_t> &file,
+                                   unsigned long rounds) {
+    unsigned long allocsBefore = 0;
+    uint64_t start = 0;
+    for (unsigned long i = 0; i < rounds; i++) {
+        file.clear();
+        file.reserve(ride.size() * 8 + RIDE_BLOCK_BYTES);
+        if (i == 0) {
+            allocsBefore = allocationCount;
+            start = nowNs();
+        }
+        writeRideFile(file, ride);
+    }
+
+    uint64_t elapsed = nowNs() - start;
+    BenchResult r;
+    r.nsPerItem = (double)elapsed / (ride.size() * rounds);
+    r.bytesPerSec = file.size() * rounds * 1e9 / elapsed;
+    r.allocsPerItem = (double)(allocationCount - allocsBefore) / (ride.size() * rounds);
+    return r;
+}
+
+// ✅ The exporters' read path; also checks every sample comes back as written, and the
+// summary slot against a full pass
+static BenchResult benchRideDecode(const std::vector<RideSample> &ride, const std::vector<uint8_t> &file,
+                                   unsigned long rounds, size_t &mismatches) {
+    mismatches = 0;
+    unsigned long allocsBefore = allocationCount;
+    uint64_t start = nowNs();
+
+    for (unsigned long i = 0; i < rounds; i++) {
+        MemoryReader memory = {&file, 0};
+        RideReader reader;
+        RideSample sample;
+        size_t n = 0;
+        if (!reader.open(readMemory, &memory)) {
+            mismatches = ride.size();
+            break;
+        }
+        while (reader.next(sample)) {
+            if (n >= ride.size() || !sameSample(sample, ride[n])) mismatches++;
+            n++;
+        }
+        if (n != ride.size()) mismatches++;
+    }
+    uint64_t elapsed = nowNs() - start;
+
+    MemoryReader memory = {&file, 0};
+    RideSummary stored, scanned;
+    if (!ride_read_summary(file.data() + file.size() - RIDE_BLOCK_BYTES, stored) ||
+        !ride_summarize(readMemory, &memory, scanned) || stored.samples != scanned.samples ||
+        stored.pauses != scanned.pauses || stored.lastSecond != scanned.lastSecond ||
+        stored.unixStart != scanned.unixStart) {
+        mismatches++;
+    }
+
+    BenchResult r;
+    r.nsPerItem = (double)elapsed / (ride.size() * rounds);
+    r.bytesPerSec = file.size() * rounds * 1e9 / elapsed;
+    r.allocsPerItem = (double)(allocationCount - allocsBefore) / (ride.size() * rounds);
+    return r;
+}
+
+// ✅ The /fit download path: the summary slot, then the ride file to FIT in HTTP-sized chunks
+static BenchResult benchFitExport(const std::vector<uint8_t> &file, size_t samples, unsigned long rounds,
+                                  size_t &fitBytes) {
+    FitEncoder encoder;
+    uint8_t chunk[FIT_CHUNK_BYTES];
+    fitBytes = 0;
+    unsigned long allocsBefore = allocationCount;
+    uint64_t start = nowNs();
+
+    for (unsigned long i = 0; i < rounds; i++) {
+        MemoryReader memory = {&file, 0};
+        RideSummary summary;
+        if (!ride_read_summary(file.data() + file.size() - RIDE_BLOCK_BYTES, summary) ||
+            !encoder.begin(readMemory, &memory, summary)) {
+            break;
+        }
+        fitBytes = 0;
+        for (size_t n; (n = encoder.read(chunk, sizeof(chunk))) > 0;) fitBytes += n;
+    }
+
+    uint64_t elapsed = nowNs() - start;
+    BenchResult r;
+    r.nsPerItem = (double)elapsed / (samples * rounds);
+    r.bytesPerSec = fitBytes * rounds * 1e9 / elapsed;
+    r.allocsPerItem = (double)(allocationCount - allocsBefore) / (samples * rounds);
+    return r;
+}
+
+// ✅ One notify tick with every measurement subscribed: Indoor Bike Data, Cycling
+// Power, CSC and Heart Rate, all encoded from the same snapshot
+static BenchResult benchMeasurements(BLEFTMS &ftms, unsigned long iterations) {
+    NimBLEServer *server = NimBLEDevice::createServer();
+    NimBLEConnInfo central;
+    central.connHandle = 1;
+    server->callbacks->onConnect(server, central);
+    for (uint8_t m = 0; m < MEASUREMENT_COUNT; m++) ftms.setSubscribed((Measurement)m, central.connHandle, true);
+
+    FTMSDataStorage sample;
+    sample.speed = 30.0f;
+    sample.heart_rate = 140;
+    uint32_t nowMs = 0;
+    unsigned long allocsBefore = allocationCount;
+    uint64_t start = nowNs();
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        sample.cadence = 80 + (i & 15);
+        sample.instantaneous_power = 200 + (i & 63);
+        nowMs += FTMS_DEFAULT_KEEPALIVE_MS;  // Always due, never rate limited
+        ftms.updateMeasurements(sample, true, nowMs);
+    }
+
+    uint64_t elapsed = nowNs() - start;
+    BenchResult r;
+    r.nsPerItem = (double)elapsed / iterations;
+    r.bytesPerSec = iterations * (FTMS_INDOOR_BIKE_DATA_LEN + CPS_MEASUREMENT_MAX_LEN + CSC_MEASUREMENT_LEN +
+                                  HR_MEASUREMENT_LEN) * 1e9 / elapsed;
+    r.allocsPerItem = (double)(allocationCount - allocsBefore) / iterations;
+    return r;
+}
+
+static BenchResult benchEncoder(BLEFTMS &ftms, unsigned long iterations) {
+    FTMSDataStorage samples[16];
+    for (int i = 0; i < 16; i++) {
+        samples[i].speed = 25.0f + i;
+        samples[i].cadence = 80 + i;
+        samples[i].distance = 1000 * i;
+        samples[i].resistance = i * 0.5f;
+        samples[i].instantaneous_power = 200 + i * 10;
+        samples[i].elapsed_time = 60 * i;
+        samples[i].energy_joules = 12000 * i;
+    }
+
+    uint8_t data[FTMS_INDOOR_BIKE_DATA_LEN];
+    uint32_t sink = 0;
+    unsigned long allocsBefore = allocationCount;
+    uint64_t start = nowNs();
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        ftms.prepareFTMSData(data, samples[i & 15]);
+        sink += data[11];
+    }
+
+    uint64_t elapsed = nowNs() - start;
+    if (sink == 0xFFFFFFFF) printf("\n");  // Keep the encoder from being optimized away
+
+    BenchResult r;
+    r.nsPerItem = (double)elapsed / iterations;
+    r.bytesPerSec = iterations * sizeof(data) * 1e9 / elapsed;
+    r.allocsPerItem = (double)(allocationCount - allocsBefore) / iterations;
+    return r;
+}
+
+int main(int argc, char **argv) {
+    unsigned long frameCount = DEFAULT_FRAME_COUNT;
+    const char *capturePath = nullptr;
+    double maxNsPerFrame = 0;
+
+    if (argc > 1 && strcmp(argv[1], "stress") == 0) {
+        return runSeqlockStress(argc > 2 ? atoi(argv[2]) : DEFAULT_STRESS_SECONDS);
+    }
+    if (argc > 2 && strcmp(argv[1], "replay") == 0) {
+        return runReplay(argv[2], argc > 3 ? atof(argv[3]) : 0);
+    }
+    if (argc > 3 && strcmp(argv[1], "convert") == 0) {
+        return runConvert(argv[2], argc - 3, argv + 3);
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-ns") == 0 && i + 1 < argc) {
+            maxNsPerFrame = atof(argv[++i]);
+        } else if (argv[i][0] >= '0' && argv[i][0] <= '9') {
+            frameCount = strtoul(argv[i], nullptr, 10);
+        } else {
+            capturePath = argv[i];
+        }
+    }
+
+    std::vector<uint8_t> capture;
+    size_t frames = capturePath ? loadCapture(capture, capturePath) : buildSyntheticCapture(capture, frameCount);
+    if (frames == 0) {
+        fprintf(stderr, "No frames to replay\n");
+        return 1;
+    }
+    printf("Replaying %zu frames (%zu bytes)%s%s\n", frames, capture.size(),
+           capturePath ? " from " : " (synthetic)", capturePath ? capturePath : "");
+
+    ANTParser parser;
+    BLEFTMS ftms;
+    serialIngest.begin(Serial, SERIAL_BAUDRATE);
+
+    BenchResult parse = benchParser(parser, capture, frames);
+    report("ANTParser::readSerial", parse);
+
+    const SerialIngestStats &ingest = serialIngest.getStats();
+    const ANTFrameDecoderStats &decoded = parser.getDecoderStats();
+    printf("  ingest: %u bytes in, %u overruns, ring high-water %u/%u bytes\n",
+           ingest.bytesIn, ingest.overruns, ingest.highWater, (unsigned)SerialRing::capacity());
+    printf("  decoder: %u frames, %u CRC errors, %u length errors, %u skipped bytes\n",
+           decoded.frames, decoded.crcErrors, decoded.lengthErrors, decoded.skippedBytes);
+    printf("  dispatch: %u unhandled pages, %u unknown device frames\n",
+           parser.getUnhandledPageTotal(), parser.getUnknownDeviceFrames());
+
+    std::vector<uint8_t> linkCapture;
+    size_t packets = buildLinkV2Capture(linkCapture, capture, LINK_V2_BATCH_FRAMES);
+    parser.setSerialLinkVersion(SERIAL_LINK_V2);
+    report("readSerial (link v2)", benchParser(parser, linkCapture, frames));
+    parser.setSerialLinkVersion(SERIAL_LINK_V1);
+    const SerialLinkV2Stats &link = parser.getLinkV2Stats();
+    printf("  link v2: %zu packets of <= %d messages, %zu bytes on the wire (v1: %zu, %.0f%%), "
+           "%u messages, %u CRC errors, %u drops\n",
+           packets, LINK_V2_BATCH_FRAMES, linkCapture.size(), capture.size(),
+           capture.size() ? linkCapture.size() * 100.0 / capture.size() : 0.0, link.messages, link.crcErrors, link.drops);
+
+    report("ANTParser::readWebSocket", benchWebSocket(parser, capture, frames));
+    const WebSocketIngestStats &wsStats = wsIngest.getStats();
+    const ANTFrameDecoderStats &wsDecoded = parser.getWebSocketDecoderStats();
+    printf("  ws ingest: %u messages, %u overruns, %u rejected; decoder: %u frames, %u CRC errors\n",
+           wsStats.messages, wsStats.overruns, wsStats.rejected, wsDecoded.frames, wsDecoded.crcErrors);
+    report("prepareFTMSData", benchEncoder(ftms, frameCount));
+    ftms.begin();
+    report("updateMeasurements", benchMeasurements(ftms, frameCount / 4));
+
+    std::vector<RideSample> ride;
+    std::vector<uint8_t> rideFile;
+    buildSyntheticRide(ride, RIDE_BENCH_SECONDS);
+    unsigned long rideRounds = frameCount / ride.size() / 10 + 1;
+    report("RideBlockWriter::add", benchRideEncode(ride, rideFile, rideRounds));
+    size_t payload = writeRideFile(rideFile, ride);
+    size_t mismatches;
+    report("RideReader::next", benchRideDecode(ride, rideFile, rideRounds, mismatches));
+    printf("  ride: %zu samples, %zu bytes (%.2f B/sample, %.1f payload), %.0f hours per MB, %zu mismatches\n",
+           ride.size(), rideFile.size(), (double)rideFile.size() / ride.size(), (double)payload / ride.size(),
+           1048576.0 / rideFile.size() * ride.size() / 3600, mismatches);
+    size_t fitBytes;
+    report("FitEncoder::read", benchFitExport(rideFile, ride.size(), rideRounds, fitBytes));
+    printf("  fit: %zu bytes (%.1f B/sample), %zu bytes of encoder state\n", fitBytes,
+           (double)fitBytes / ride.size(), sizeof(FitEncoder));
+
+    if (maxNsPerFrame > 0 && parse.nsPerItem > maxNsPerFrame) {
+        fprintf(stderr, "Parser regression: %.1f ns/frame exceeds limit of %.1f ns/frame\n",
+                parse.nsPerItem, maxNsPerFrame);
+        return 2;
+    }
+    return 0;
+}
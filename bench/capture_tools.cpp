@@ -0,0 +1,207 @@
+// Capture tools for the binary format in src/ant_capture.h.
+//
+//   .pio/build/native/program convert <out.acap> <ant_data.log>...
+//   .pio/build/native/program replay <capture.acap> [speed]
+//
+// convert turns DeviceScanner/scanner.py logs (oldest file first when the log has
+// rotated) into a capture. The log only has millisecond timestamps, so frames logged
+// in the same millisecond share one.
+//
+// replay feeds a capture into ANTParser on the capture's own timeline, through the
+// same ingest path each frame arrived on (UART ring or /ws ring), and prints the fused
+// data once per captured second. speed 1 is real time, 10 ten times faster, 0 (the
+// default) as fast as possible; the parser sees capture time either way, so sensor
+// timeouts behave as they did on the device. 0xF0 commands in the capture are skipped.
+
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "ant_capture.h"
+#include "ant_parser.h"
+#include "serial_ingest.h"
+#include "websocket_ingest.h"
+
+#define LOG_LINE_MAX 512
+#define REPLAY_PRINT_INTERVAL_US 1000000ULL
+
+bool readFile(std::vector<uint8_t> &out, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        out.insert(out.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return true;
+}
+
+// ✅ Days since 1970-01-01 of a civil date (proleptic Gregorian)
+static int64_t daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;
+    int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// "2025-03-01 10:00:00,123 - 📡 Device 1 (Type 17): A41108...XX (printf ...)"
+// Returns the frame length, or 0 if the line holds no valid frame
+static uint8_t parseLogLine(const char *line, uint64_t *timestampUs, uint8_t *frame) {
+    int year, month, day, hour, minute, second, millis;
+    if (sscanf(line, "%d-%d-%d %d:%d:%d,%d", &year, &month, &day, &hour, &minute, &second, &millis) != 7) {
+        return 0;
+    }
+    const char *hex = strstr(line, "): ");
+    if (!hex) return 0;
+    hex += 3;
+
+    size_t len = 0;
+    while (hexValue(hex[0]) >= 0 && hexValue(hex[1]) >= 0) {
+        if (len == CAPTURE_FRAME_MAX_BYTES) return 0;
+        frame[len++] = hexValue(hex[0]) << 4 | hexValue(hex[1]);
+        hex += 2;
+    }
+    if (len < ANT_FRAME_OVERHEAD || (frame[0] != ANT_SYNC_BYTE && frame[0] != CMD_SYNC_BYTE) ||
+        (size_t)frame[2] + ANT_FRAME_OVERHEAD != len) {
+        return 0;
+    }
+    uint8_t crc = 0;
+    for (size_t i = 3; i < len - 1; i++) crc ^= frame[i];
+    if (crc != frame[len - 1]) return 0;
+
+    int64_t seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    *timestampUs = (uint64_t)(seconds * 1000 + millis) * 1000;
+    return len;
+}
+
+int runConvert(const char *outPath, int inputCount, char **inputs) {
+    FILE *out = fopen(outPath, "wb");
+    if (!out) {
+        fprintf(stderr, "Cannot create %s\n", outPath);
+        return 1;
+    }
+    uint8_t header[CAPTURE_FILE_HEADER_BYTES];
+    capture_write_file_header(header);
+    fwrite(header, 1, sizeof(header), out);
+
+    static CaptureBlockWriter writer;
+    static uint8_t block[CAPTURE_BLOCK_MAX_BYTES];
+    size_t bytesIn = 0, bytesOut = sizeof(header);
+    unsigned long lines = 0, frames = 0, skipped = 0;
+
+    auto writeBlock = [&]() {
+        size_t n = writer.finish(block);
+        fwrite(block, 1, n, out);
+        bytesOut += n;
+    };
+
+    for (int i = 0; i < inputCount; i++) {
+        FILE *in = fopen(inputs[i], "r");
+        if (!in) {
+            fprintf(stderr, "Cannot open %s\n", inputs[i]);
+            fclose(out);
+            return 1;
+        }
+        char line[LOG_LINE_MAX];
+        while (fgets(line, sizeof(line), in)) {
+            lines++;
+            bytesIn += strlen(line);
+            uint64_t timestampUs;
+            uint8_t frame[CAPTURE_FRAME_MAX_BYTES];
+            uint8_t len = parseLogLine(line, &timestampUs, frame);
+            if (len == 0) {
+                skipped++;
+                continue;
+            }
+            if (!writer.add(timestampUs, CAPTURE_SOURCE_SERIAL, frame, len)) {
+                writeBlock();
+                writer.add(timestampUs, CAPTURE_SOURCE_SERIAL, frame, len);
+            }
+            frames++;
+        }
+        fclose(in);
+    }
+    writeBlock();
+    fclose(out);
+
+    printf("%lu lines, %lu frames, %lu skipped; %zu bytes of log -> %zu bytes (%.1fx)\n",
+           lines, frames, skipped, bytesIn, bytesOut, bytesOut ? (double)bytesIn / bytesOut : 0.0);
+    return frames ? 0 : 1;
+}
+
+int runReplay(const char *path, double speed) {
+    std::vector<uint8_t> capture;
+    CaptureReader reader;
+    if (!readFile(capture, path) || !reader.open(capture.data(), capture.size())) {
+        fprintf(stderr, "Cannot read capture %s\n", path);
+        return 1;
+    }
+
+    ANTParser parser;
+    serialIngest.begin(Serial, SERIAL_BAUDRATE);
+
+    CaptureRecord record;
+    uint64_t firstUs = 0, nextPrintUs = 0;
+    unsigned long frames = 0, commands = 0;
+    auto wallStart = std::chrono::steady_clock::now();
+
+    auto print = [&](uint64_t captureUs) {
+        parser.refresh();
+        FTMSDataStorage data = parser.getFTMSData();
+        printf("%9.1f s  %4u W  %3u rpm  %5.1f km/h  %3u bpm\n", (captureUs - firstUs) / 1e6,
+               data.instantaneous_power, data.cadence, data.speed, data.heart_rate);
+    };
+
+    while (reader.next(record)) {
+        if (frames + commands == 0) {
+            firstUs = record.timestampUs;
+            nextPrintUs = firstUs + REPLAY_PRINT_INTERVAL_US;
+        }
+        while (record.timestampUs >= nextPrintUs) {
+            native_set_clock_us(nextPrintUs - firstUs + 1);
+            print(nextPrintUs);
+            nextPrintUs += REPLAY_PRINT_INTERVAL_US;
+        }
+
+        uint64_t offsetUs = record.timestampUs - firstUs;
+        if (speed > 0) {
+            std::this_thread::sleep_until(wallStart + std::chrono::microseconds((uint64_t)(offsetUs / speed)));
+        }
+        native_set_clock_us(offsetUs + 1);  // 0 means "never" to some of the parser's timers
+
+        if (record.frame[0] == CMD_SYNC_BYTE) {
+            commands++;  // SETNAME and friends would reconfigure (or restart) the host
+            continue;
+        }
+        if (record.source == CAPTURE_SOURCE_WEBSOCKET) {
+            wsIngest.write(record.frame, record.length);
+            parser.readWebSocket();
+        } else {
+            Serial.feed(record.frame, record.length);
+            parser.readSerial();
+        }
+        frames++;
+    }
+    if (frames) print(record.timestampUs);
+
+    const ANTFrameDecoderStats &serial = parser.getDecoderStats();
+    const ANTFrameDecoderStats &websocket = parser.getWebSocketDecoderStats();
+    printf("Replayed %lu frames (%u serial, %u /ws) from %u blocks, %lu commands skipped\n",
+           frames, serial.frames, websocket.frames, reader.getBlocks(), commands);
+    printf("  dispatch: %u unhandled pages, %u unknown device frames\n",
+           parser.getUnhandledPageTotal(), parser.getUnknownDeviceFrames());
+    if (reader.isTruncated()) {
+        printf("  capture ends in a damaged or partial block (recorder cut off mid-write?)\n");
+    }
+    return 0;
+}
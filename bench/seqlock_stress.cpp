@@ -0,0 +1,78 @@
+// Torn-read stress test for ANTParser's FTMSDataStorage snapshot.
+//
+//   .pio/build/native/program stress [seconds]
+//
+// One writer thread ingests FE Trainer Data pages (0x19) whose cadence, accumulated
+// power and instantaneous power are all derived from one counter; reader threads
+// hammer getFTMSData() and check that every snapshot comes from a single page.
+
+#include <Arduino.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "ant_parser.h"
+
+#define STRESS_READERS 3
+
+static void buildTrainerFrame(uint8_t *frame, uint8_t cadence) {
+    uint16_t accumulated = cadence * 257;
+    uint16_t power = (cadence * 13) & 0x0FFF;
+    uint8_t payload[8] = {0x19, cadence, cadence, (uint8_t)(accumulated & 0xFF), (uint8_t)(accumulated >> 8),
+                          (uint8_t)(power & 0xFF), (uint8_t)((power >> 8) & 0x0F), 0x30};
+
+    frame[0] = 0xA4;
+    frame[1] = (uint8_t)DeviceType::FitnessEquipment;
+    frame[2] = 8;
+    uint8_t crc = 0;
+    for (int i = 0; i < 8; i++) {
+        frame[3 + i] = payload[i];
+        crc ^= payload[i];
+    }
+    frame[11] = crc;
+}
+
+static bool isConsistent(const FTMSDataStorage &data) {
+    if (!data.hasData) return data.cadence == 0 && data.instantaneous_power == 0;
+    return data.accumulated_power == (uint16_t)(data.cadence * 257) &&
+           data.instantaneous_power == ((data.cadence * 13) & 0x0FFF);
+}
+
+int runSeqlockStress(unsigned seconds) {
+    ANTParser parser;
+    std::atomic<bool> running(true);
+    std::atomic<unsigned long> reads(0), torn(0), writes(0);
+
+    std::thread writer([&]() {
+        uint8_t frame[12];
+        uint8_t cadence = 0;
+        while (running.load(std::memory_order_relaxed)) {
+            buildTrainerFrame(frame, cadence);
+            parser.ingest(frame, sizeof(frame));
+            cadence = (cadence + 1) % 0xFF;  // 0xFF means "invalid" in page 0x19
+            writes.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < STRESS_READERS; r++) {
+        readers.emplace_back([&]() {
+            unsigned long localReads = 0, localTorn = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                if (!isConsistent(parser.getFTMSData())) localTorn++;
+                localReads++;
+            }
+            reads.fetch_add(localReads);
+            torn.fetch_add(localTorn);
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    running.store(false);
+    writer.join();
+    for (auto &t : readers) t.join();
+
+    printf("seqlock stress: %lu writes, %lu reads by %d readers in %u s, %lu torn\n",
+           writes.load(), reads.load(), STRESS_READERS, seconds, torn.load());
+    return torn.load() == 0 ? 0 : 3;
+}
@@ -0,0 +1,107 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// ✅ Host stand-in for the Arduino core. Only what ant_parser / ble_ftms use.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <functional>
+#include <vector>
+
+#define SERIAL_8N1 0x800001c
+
+typedef enum {
+    UART_NO_ERROR,
+    UART_BREAK_ERROR,
+    UART_BUFFER_FULL_ERROR,
+    UART_FIFO_OVF_ERROR,
+    UART_FRAME_ERROR,
+    UART_PARITY_ERROR
+} hardwareSerial_error_t;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void esp_restart();
+// ✅ From the first call on, millis()/micros() return this instead of the real clock
+// (capture replay runs the parser on the capture's timeline at any speed)
+void native_set_clock_us(uint64_t us);
+
+class String {
+public:
+    String() {}
+    String(const char *s) : str(s ? s : "") {}
+    String(const std::string &s) : str(s) {}
+
+    const char *c_str() const { return str.c_str(); }
+    unsigned int length() const { return str.length(); }
+
+    String &operator+=(char c) { str += c; return *this; }
+    String &operator+=(const String &s) { str += s.str; return *this; }
+    bool operator==(const char *s) const { return str == s; }
+    bool operator==(const String &s) const { return str == s.str; }
+
+    bool startsWith(const char *prefix) const { return str.compare(0, strlen(prefix), prefix) == 0; }
+    String substring(unsigned int from) const { return from < str.size() ? String(str.substr(from)) : String(); }
+
+    friend String operator+(const char *lhs, const String &rhs) { return String(std::string(lhs) + rhs.str); }
+
+private:
+    std::string str;
+};
+
+// ✅ Serial replays bytes handed to it with feed(); nothing is ever written out.
+// feed() fires the onReceive callback the way the UART event task does on the device.
+class HardwareSerial {
+public:
+    typedef std::function<void(void)> OnReceiveCb;
+    typedef std::function<void(hardwareSerial_error_t)> OnReceiveErrorCb;
+
+    void begin(unsigned long baud, uint32_t config = SERIAL_8N1, int8_t rxPin = -1, int8_t txPin = -1) {}
+    size_t setRxBufferSize(size_t size) { return size; }
+    void onReceive(OnReceiveCb function, bool onlyOnTimeout = false) { rxCallback = function; }
+    void onReceiveError(OnReceiveErrorCb function) {}
+
+    void feed(const uint8_t *data, size_t len) {
+        rxData = data;
+        rxLen = len;
+        rxPos = 0;
+        if (rxCallback) rxCallback();
+    }
+
+    int available() { return static_cast<int>(rxLen - rxPos); }
+    int read() { return rxPos < rxLen ? rxData[rxPos++] : -1; }
+    size_t read(uint8_t *buffer, size_t size) {
+        size_t n = (rxLen - rxPos) < size ? (rxLen - rxPos) : size;
+        memcpy(buffer, rxData + rxPos, n);
+        rxPos += n;
+        return n;
+    }
+
+    // ✅ TX side: bytes are kept in `txData` so callers can inspect what was sent
+    int availableForWrite() { return 4096; }
+    size_t write(const uint8_t *buffer, size_t size) {
+        txData.insert(txData.end(), buffer, buffer + size);
+        return size;
+    }
+    std::vector<uint8_t> txData;
+
+    size_t println(const char *) { return 0; }
+    size_t printf(const char *, ...) { return 0; }
+
+private:
+    const uint8_t *rxData = nullptr;
+    size_t rxLen = 0;
+    size_t rxPos = 0;
+    OnReceiveCb rxCallback;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;  // Debug port
+
+#endif  // NATIVE_ARDUINO_H
@@ -0,0 +1,202 @@
+#ifndef NATIVE_NIMBLE_DEVICE_H
+#define NATIVE_NIMBLE_DEVICE_H
+
+// ✅ Host stand-in for the parts of NimBLE-Arduino 2.x used by ble_ftms.
+// Characteristics keep the last value written/notified so callers can inspect it.
+
+#include <Arduino.h>
+#include <vector>
+
+// From the NimBLE host's ble_gap.h
+#define BLE_GAP_LE_PHY_1M 1
+#define BLE_GAP_LE_PHY_2M 2
+#define BLE_GAP_LE_PHY_1M_MASK 0x01
+#define BLE_GAP_LE_PHY_2M_MASK 0x02
+
+namespace NIMBLE_PROPERTY {
+    enum : uint16_t {
+        READ = 0x0002,
+        WRITE_NR = 0x0004,
+        WRITE = 0x0008,
+        NOTIFY = 0x0010,
+        INDICATE = 0x0020
+    };
+}
+
+class NimBLEUUID {
+public:
+    NimBLEUUID(uint16_t uuid16) : uuid(uuid16) {}
+    uint16_t uuid;
+};
+
+class NimBLEAddress {
+public:
+    std::string toString() const { return "00:00:00:00:00:00"; }
+};
+
+class NimBLEConnInfo {
+public:
+    uint16_t getConnHandle() const { return connHandle; }
+    uint16_t getConnInterval() const { return interval; }
+    uint16_t getConnLatency() const { return latency; }
+    uint16_t getConnTimeout() const { return timeout; }
+    uint16_t getMTU() const { return mtu; }
+    uint16_t connHandle = 0;
+    uint16_t interval = 24;
+    uint16_t latency = 0;
+    uint16_t timeout = 400;
+    uint16_t mtu = 23;
+};
+
+class NimBLECharacteristic;
+
+class NimBLECharacteristicCallbacks {
+public:
+    virtual ~NimBLECharacteristicCallbacks() {}
+    virtual void onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo) {}
+    virtual void onSubscribe(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo, uint16_t subValue) {}
+};
+
+class NimBLECharacteristic {
+public:
+    explicit NimBLECharacteristic(uint16_t uuid16, uint16_t props) : uuid(uuid16), properties(props) {}
+
+    void setCallbacks(NimBLECharacteristicCallbacks *cb) { callbacks = cb; }
+
+    void setValue(const uint8_t *data, size_t len) { value.assign(data, data + len); }
+    bool notify(const uint8_t *data, size_t len, uint16_t connHandle = 0xFFFF) {
+        if (connHandle == refuseConnHandle) return false;  // Simulated congested link
+        setValue(data, len);
+        notifyCount++;
+        return true;
+    }
+
+    bool indicate(const uint8_t *data, size_t len, uint16_t connHandle = 0xFFFF) {
+        return notify(data, len, connHandle);
+    }
+
+    // Simulates a client write: stores the value and runs onWrite like the NimBLE host task
+    void write(const uint8_t *data, size_t len, uint16_t connHandle = 0) {
+        setValue(data, len);
+        NimBLEConnInfo info;
+        info.connHandle = connHandle;
+        if (callbacks) callbacks->onWrite(this, info);
+    }
+
+    // Simulates a client writing the CCCD (1 = notify, 2 = indicate, 0 = off)
+    void subscribe(uint16_t connHandle, uint16_t subValue) {
+        NimBLEConnInfo info;
+        info.connHandle = connHandle;
+        if (callbacks) callbacks->onSubscribe(this, info, subValue);
+    }
+
+    const std::vector<uint8_t> &getValue() const { return value; }
+
+    uint16_t uuid;
+    uint16_t properties;
+    uint32_t notifyCount = 0;
+    uint16_t refuseConnHandle = 0xFFFE;
+    NimBLECharacteristicCallbacks *callbacks = nullptr;
+
+private:
+    std::vector<uint8_t> value;
+};
+
+class NimBLEService {
+public:
+    NimBLECharacteristic *createCharacteristic(const NimBLEUUID &uuid, uint16_t properties) {
+        characteristics.push_back(new NimBLECharacteristic(uuid.uuid, properties));
+        return characteristics.back();
+    }
+    NimBLECharacteristic *getCharacteristic(const NimBLEUUID &uuid) {
+        for (NimBLECharacteristic *c : characteristics) {
+            if (c->uuid == uuid.uuid) return c;
+        }
+        return nullptr;
+    }
+    bool start() { return true; }
+    uint16_t uuid = 0;
+
+private:
+    std::vector<NimBLECharacteristic *> characteristics;
+};
+
+class NimBLEServer;
+
+class NimBLEServerCallbacks {
+public:
+    virtual ~NimBLEServerCallbacks() {}
+    virtual void onConnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo) {}
+    virtual void onDisconnect(NimBLEServer *pServer, NimBLEConnInfo &connInfo, int reason) {}
+    virtual void onConnParamsUpdate(NimBLEConnInfo &connInfo) {}
+    virtual void onMTUChange(uint16_t mtu, NimBLEConnInfo &connInfo) {}
+    virtual void onPhyUpdate(NimBLEConnInfo &connInfo, uint8_t txPhy, uint8_t rxPhy) {}
+};
+
+class NimBLEServer {
+public:
+    void setCallbacks(NimBLEServerCallbacks *cb) { callbacks = cb; }
+    NimBLEService *createService(const NimBLEUUID &uuid) {
+        services.push_back(new NimBLEService());
+        services.back()->uuid = uuid.uuid;
+        return services.back();
+    }
+    NimBLEService *getServiceByUUID(const NimBLEUUID &uuid) {
+        for (NimBLEService *s : services) {
+            if (s->uuid == uuid.uuid) return s;
+        }
+        return nullptr;
+    }
+
+    // Link requests are recorded, not negotiated
+    bool updateConnParams(uint16_t connHandle, uint16_t minInterval, uint16_t maxInterval,
+                          uint16_t latency, uint16_t timeout) {
+        lastParams[0] = minInterval;
+        lastParams[1] = maxInterval;
+        lastParams[2] = latency;
+        lastParams[3] = timeout;
+        return true;
+    }
+    bool setDataLen(uint16_t connHandle, uint16_t txOctets) { return true; }
+    bool updatePhy(uint16_t connHandle, uint8_t txPhyMask, uint8_t rxPhyMask, uint16_t phyOptions) { return true; }
+    std::vector<uint16_t> getPeerDevices() const { return peers; }
+
+    NimBLEServerCallbacks *callbacks = nullptr;
+    std::vector<uint16_t> peers;
+    uint16_t lastParams[4] = {0, 0, 0, 0};
+
+private:
+    std::vector<NimBLEService *> services;
+};
+
+class NimBLEAdvertisementData {
+public:
+    void setFlags(uint8_t) {}
+    void setAppearance(uint16_t) {}
+    void addData(const std::vector<uint8_t> &) {}
+    void setName(const char *) {}
+    void setManufacturerData(const uint8_t *, size_t) {}
+};
+
+class NimBLEAdvertising {
+public:
+    void setAdvertisementData(const NimBLEAdvertisementData &) {}
+    void setScanResponseData(const NimBLEAdvertisementData &) {}
+    bool start(uint32_t duration = 0) { advertising = true; return true; }
+    bool isAdvertising() const { return advertising; }
+
+private:
+    bool advertising = false;
+};
+
+class NimBLEDevice {
+public:
+    static void init(const char *name) {}
+    static bool setMTU(uint16_t mtu) { return true; }
+    static bool setDefaultPhy(uint8_t txPhyMask, uint8_t rxPhyMask) { return true; }
+    static NimBLEServer *createServer() { static NimBLEServer server; return &server; }
+    static NimBLEAdvertising *getAdvertising() { static NimBLEAdvertising adv; return &adv; }
+    static NimBLEAddress getAddress() { return NimBLEAddress(); }
+};
+
+#endif  // NATIVE_NIMBLE_DEVICE_H
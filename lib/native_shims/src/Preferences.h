@@ -0,0 +1,41 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+
+// ✅ In-memory NVS stand-in, keyed by "namespace/key"
+class Preferences {
+public:
+    bool begin(const char *name, bool readOnly = false) { ns = name; return true; }
+    void end() {}
+
+    String getString(const char *key, const String &defaultValue = String()) {
+        auto it = values.find(ns + "/" + key);
+        return it != values.end() ? String(it->second) : defaultValue;
+    }
+
+    size_t putString(const char *key, const String &value) {
+        values[ns + "/" + key] = value.c_str();
+        return value.length();
+    }
+
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0) { return getInt(key, defaultValue); }
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0) { return getInt(key, defaultValue); }
+    uint32_t getUInt(const char *key, uint32_t defaultValue = 0) { return getInt(key, defaultValue); }
+    size_t putUChar(const char *key, uint8_t value) { ints[ns + "/" + key] = value; return 1; }
+    size_t putUShort(const char *key, uint16_t value) { ints[ns + "/" + key] = value; return 2; }
+    size_t putUInt(const char *key, uint32_t value) { ints[ns + "/" + key] = value; return 4; }
+
+private:
+    uint32_t getInt(const char *key, uint32_t defaultValue) {
+        auto it = ints.find(ns + "/" + key);
+        return it != ints.end() ? it->second : defaultValue;
+    }
+
+    std::string ns;
+    std::map<std::string, std::string> values;
+    std::map<std::string, uint32_t> ints;
+};
+
+#endif  // NATIVE_PREFERENCES_H
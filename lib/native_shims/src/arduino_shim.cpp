@@ -0,0 +1,37 @@
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+static const auto bootTime = std::chrono::steady_clock::now();
+static bool clockOverridden = false;
+static uint64_t overrideUs = 0;
+
+void native_set_clock_us(uint64_t us) {
+    clockOverridden = true;
+    overrideUs = us;
+}
+
+unsigned long millis() {
+    if (clockOverridden) return overrideUs / 1000;
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+    if (clockOverridden) return overrideUs;
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// ✅ A reboot request on the host just ends the process
+void esp_restart() {
+    fprintf(stderr, "esp_restart() called\n");
+    exit(0);
+}
@@ -0,0 +1,263 @@
+#include "ant_capture.h"
+
+#define LZF_MAX_LITERALS 32
+#define LZF_MAX_OFFSET 8192
+#define LZF_MAX_MATCH (2 + 7 + 255)
+
+static inline uint8_t *putUInt16(uint8_t *p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static inline uint16_t getUInt16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t hashAt(const uint8_t *p) {
+    uint32_t v = (p[0] << 16) | (p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - CAPTURE_HASH_BITS);
+}
+
+size_t capture_compress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize) {
+    uint16_t table[1 << CAPTURE_HASH_BITS];  // Position + 1 of the last 3-byte sequence seen
+    memset(table, 0, sizeof(table));
+
+    const uint8_t *ip = in;
+    const uint8_t *end = in + len;
+    uint8_t *op = out;
+    uint8_t *oend = out + outSize;
+
+    if (op == oend) return 0;
+    uint8_t *control = op++;  // Reserved for the literal run being collected
+    uint8_t literals = 0;
+
+    while (ip < end) {
+        if (end - ip >= 3) {
+            uint32_t h = hashAt(ip);
+            const uint8_t *ref = table[h] ? in + table[h] - 1 : nullptr;
+            table[h] = (uint16_t)(ip - in + 1);
+
+            size_t offset = ref ? ip - ref - 1 : 0;
+            if (ref && offset < LZF_MAX_OFFSET && ref[0] == ip[0] && ref[1] == ip[1] && ref[2] == ip[2]) {
+                size_t maxMatch = (size_t)(end - ip) < LZF_MAX_MATCH ? end - ip : LZF_MAX_MATCH;
+                size_t match = 3;
+                while (match < maxMatch && ref[match] == ip[match]) match++;
+
+                // ✅ Close the literal run, or give back its unused control byte
+                if (literals) *control = literals - 1;
+                else op--;
+
+                size_t code = match - 2;
+                if (oend - op < (code < 7 ? 2 : 3) + 1) return 0;
+                if (code < 7) {
+                    *op++ = (code << 5) | (offset >> 8);
+                } else {
+                    *op++ = (7 << 5) | (offset >> 8);
+                    *op++ = code - 7;
+                }
+                *op++ = offset & 0xFF;
+
+                // Index the positions inside the match too; repeats are mostly whole frames
+                for (const uint8_t *p = ip + 1; p < ip + match && end - p >= 3; p++) {
+                    table[hashAt(p)] = (uint16_t)(p - in + 1);
+                }
+                ip += match;
+                control = op++;
+                literals = 0;
+                continue;
+            }
+        }
+
+        if (op == oend) return 0;
+        *op++ = *ip++;
+        if (++literals == LZF_MAX_LITERALS) {
+            *control = literals - 1;
+            if (op == oend) return 0;
+            control = op++;
+            literals = 0;
+        }
+    }
+
+    if (literals) *control = literals - 1;
+    else op--;
+    return op - out;
+}
+
+size_t capture_decompress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize) {
+    const uint8_t *ip = in;
+    const uint8_t *end = in + len;
+    uint8_t *op = out;
+    uint8_t *oend = out + outSize;
+
+    while (ip < end) {
+        uint8_t control = *ip++;
+        if (control < LZF_MAX_LITERALS) {
+            size_t n = control + 1;
+            if ((size_t)(end - ip) < n || (size_t)(oend - op) < n) return 0;
+            memcpy(op, ip, n);
+            op += n;
+            ip += n;
+            continue;
+        }
+
+        size_t n = control >> 5;
+        if (n == 7) {
+            if (ip == end) return 0;
+            n += *ip++;
+        }
+        if (ip == end) return 0;
+        size_t offset = ((control & 0x1F) << 8 | *ip++) + 1;
+        n += 2;
+        if ((size_t)(op - out) < offset || (size_t)(oend - op) < n) return 0;
+
+        const uint8_t *ref = op - offset;
+        while (n--) *op++ = *ref++;  // Byte by byte: the reference may overlap the output
+    }
+    return op - out;
+}
+
+void capture_write_file_header(uint8_t *out) {
+    memcpy(out, CAPTURE_MAGIC, 4);
+    out[4] = CAPTURE_VERSION;
+    out[5] = 0;
+    putUInt16(out + 6, CAPTURE_BLOCK_RAW_BYTES);
+}
+
+CaptureBlockWriter::CaptureBlockWriter() : rawLen(0), frames(0), baseUs(0), lastUs(0) {}
+
+bool CaptureBlockWriter::add(uint64_t timestampUs, CaptureSource source, const uint8_t *frame, uint8_t length) {
+    if (frames == 0) {
+        baseUs = timestampUs;
+        lastUs = timestampUs;
+    }
+    uint64_t delta = timestampUs > lastUs ? timestampUs - lastUs : 0;  // Never backwards
+
+    uint8_t record[CAPTURE_RECORD_MAX_BYTES];
+    size_t n = 0;
+    uint64_t v = (delta << 1) | source;
+    while (v >= 0x80) {
+        record[n++] = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    record[n++] = v;
+
+    if (length > CAPTURE_FRAME_MAX_BYTES) return true;  // Can't come from the decoder; skip
+    if (rawLen + n + length > CAPTURE_BLOCK_RAW_BYTES) return false;
+
+    memcpy(raw + rawLen, record, n);
+    memcpy(raw + rawLen + n, frame, length);
+    rawLen += n + length;
+    lastUs += delta;
+    frames++;
+    return true;
+}
+
+size_t CaptureBlockWriter::finish(uint8_t *out) {
+    if (frames == 0) return 0;
+
+    // ✅ Keep the compressed form only if it's smaller
+    uint8_t *data = out + CAPTURE_BLOCK_HEADER_BYTES;
+    size_t stored = capture_compress(raw, rawLen, data, rawLen - 1);
+    if (stored == 0) {
+        memcpy(data, raw, rawLen);
+        stored = rawLen;
+    }
+
+    uint8_t *p = out;
+    *p++ = 'B';
+    *p++ = 'K';
+    p = putUInt16(p, rawLen);
+    p = putUInt16(p, stored);
+    p = putUInt16(p, frames);
+    for (int i = 0; i < 8; i++) *p++ = (baseUs >> (8 * i)) & 0xFF;
+
+    rawLen = 0;
+    frames = 0;
+    return CAPTURE_BLOCK_HEADER_BYTES + stored;
+}
+
+CaptureReader::CaptureReader()
+    : data(nullptr), len(0), pos(0), rawLen(0), rawPos(0), framesLeft(0), lastUs(0), blocks(0), truncated(false) {}
+
+bool CaptureReader::isCapture(const uint8_t *data, size_t len) {
+    return len >= CAPTURE_FILE_HEADER_BYTES && memcmp(data, CAPTURE_MAGIC, 4) == 0;
+}
+
+bool CaptureReader::open(const uint8_t *captureData, size_t captureLen) {
+    if (!isCapture(captureData, captureLen) || captureData[4] != CAPTURE_VERSION) return false;
+    data = captureData;
+    len = captureLen;
+    pos = CAPTURE_FILE_HEADER_BYTES;
+    rawLen = rawPos = 0;
+    framesLeft = 0;
+    blocks = 0;
+    truncated = false;
+    return true;
+}
+
+bool CaptureReader::loadBlock() {
+    if (pos == len) return false;  // Clean end
+    truncated = true;  // Until the block checks out
+
+    if (len - pos < CAPTURE_BLOCK_HEADER_BYTES) return false;
+    const uint8_t *header = data + pos;
+    if (header[0] != 'B' || header[1] != 'K') return false;
+    size_t blockRaw = getUInt16(header + 2);
+    size_t stored = getUInt16(header + 4);
+    uint16_t frames = getUInt16(header + 6);
+    if (blockRaw == 0 || blockRaw > CAPTURE_BLOCK_RAW_BYTES || stored > blockRaw || frames == 0) return false;
+    if (len - pos - CAPTURE_BLOCK_HEADER_BYTES < stored) return false;  // Cut off mid-write
+
+    const uint8_t *payload = header + CAPTURE_BLOCK_HEADER_BYTES;
+    if (stored == blockRaw) {
+        memcpy(raw, payload, blockRaw);
+    } else if (capture_decompress(payload, stored, raw, sizeof(raw)) != blockRaw) {
+        return false;
+    }
+
+    lastUs = 0;
+    for (int i = 7; i >= 0; i--) lastUs = (lastUs << 8) | header[8 + i];
+    rawLen = blockRaw;
+    rawPos = 0;
+    framesLeft = frames;
+    pos += CAPTURE_BLOCK_HEADER_BYTES + stored;
+    blocks++;
+    truncated = false;
+    return true;
+}
+
+bool CaptureReader::next(CaptureRecord &record) {
+    if (truncated) return false;
+    if (framesLeft == 0 && !loadBlock()) return false;
+
+    uint64_t v = 0;
+    for (int shift = 0;; shift += 7) {
+        if (rawPos == rawLen || shift > 63) {
+            truncated = true;
+            return false;
+        }
+        uint8_t b = raw[rawPos++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+
+    if (rawLen - rawPos < 3) {
+        truncated = true;
+        return false;
+    }
+    size_t length = raw[rawPos + 2] + ANT_FRAME_OVERHEAD;
+    if (length > CAPTURE_FRAME_MAX_BYTES || rawLen - rawPos < length) {
+        truncated = true;
+        return false;
+    }
+
+    lastUs += v >> 1;
+    record.timestampUs = lastUs;
+    record.source = (CaptureSource)(v & 1);
+    record.length = length;
+    record.frame = raw + rawPos;
+    rawPos += length;
+    framesLeft--;
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef ANT_CAPTURE_H
+#define ANT_CAPTURE_H
+
+#include <Arduino.h>
+#include "ant_frame_decoder.h"
+
+// ✅ Binary capture of ingested ANT+ frames, written by the on-device recorder and the
+// host converter, read by the host replay tool and the benchmark. All little-endian.
+//
+// File:   "ACAP" | version (u8) | flags (u8, 0) | max raw block bytes (u16) | block...
+// Block:  "BK" | rawLen (u16) | storedLen (u16) | frames (u16) | baseUs (u64) | data
+//         `data` is the LZF-compressed record stream, or the records as-is when
+//         storedLen == rawLen. A block cut short by a crash ends the capture.
+// Record: varint((deltaUs << 1) | source) | frame
+//         deltaUs is from the previous record of the block (the first one: from baseUs),
+//         `frame` the bytes as received: sync | deviceType | length | payload | xor.
+// Timestamps are monotonic µs; the device counts from boot.
+
+#define CAPTURE_MAGIC "ACAP"
+#define CAPTURE_VERSION 1
+#define CAPTURE_FILE_HEADER_BYTES 8
+#define CAPTURE_BLOCK_HEADER_BYTES 16
+#define CAPTURE_BLOCK_RAW_BYTES 4096  // Records per block before compression
+#define CAPTURE_BLOCK_MAX_BYTES (CAPTURE_BLOCK_HEADER_BYTES + CAPTURE_BLOCK_RAW_BYTES)
+#define CAPTURE_FRAME_MAX_BYTES (ANT_FRAME_OVERHEAD + ANT_FRAME_MAX_PAYLOAD)
+#define CAPTURE_RECORD_MAX_BYTES (10 + CAPTURE_FRAME_MAX_BYTES)  // 64-bit varint + frame
+#define CAPTURE_HASH_BITS 10  // Compressor match table: 2 KB
+
+enum CaptureSource : uint8_t {
+    CAPTURE_SOURCE_SERIAL = 0,
+    CAPTURE_SOURCE_WEBSOCKET = 1
+};
+
+struct CaptureRecord {
+    uint64_t timestampUs;
+    CaptureSource source;
+    uint8_t length;  // Whole frame, sync to xor
+    const uint8_t *frame;  // Valid until the next CaptureReader::next()
+};
+
+// ✅ LZF byte format: control < 32 is a run of control + 1 literals, anything else a
+// back-reference of (control >> 5) + 2 bytes (7: one more length byte follows) at
+// distance ((control & 0x1F) << 8 | next byte) + 1. Return 0 if `out` is too small.
+size_t capture_compress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize);
+size_t capture_decompress(const uint8_t *in, size_t len, uint8_t *out, size_t outSize);
+
+void capture_write_file_header(uint8_t *out);
+
+// ✅ Collects records into one block; no allocation
+class CaptureBlockWriter {
+public:
+    CaptureBlockWriter();
+    // False if the record doesn't fit: finish() the block and add it to the next one
+    bool add(uint64_t timestampUs, CaptureSource source, const uint8_t *frame, uint8_t length);
+    // Header + data into `out` (CAPTURE_BLOCK_MAX_BYTES), then starts an empty block.
+    // Returns 0 if the block is empty.
+    size_t finish(uint8_t *out);
+
+    uint16_t getFrames() const { return frames; }
+    size_t getRawBytes() const { return rawLen; }
+    uint64_t getBaseUs() const { return baseUs; }
+
+private:
+    uint8_t raw[CAPTURE_BLOCK_RAW_BYTES];
+    size_t rawLen;
+    uint16_t frames;
+    uint64_t baseUs;
+    uint64_t lastUs;
+};
+
+// ✅ Walks a whole capture held in memory, one record at a time
+class CaptureReader {
+public:
+    CaptureReader();
+    bool open(const uint8_t *data, size_t len);  // False if it isn't a capture
+    bool next(CaptureRecord &record);  // False at the end or at the first damaged block
+
+    uint32_t getBlocks() const { return blocks; }
+    bool isTruncated() const { return truncated; }  // Stopped at a damaged or partial block
+
+    static bool isCapture(const uint8_t *data, size_t len);
+
+private:
+    bool loadBlock();
+
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    uint8_t raw[CAPTURE_BLOCK_RAW_BYTES];
+    size_t rawLen;
+    size_t rawPos;
+    uint16_t framesLeft;
+    uint64_t lastUs;
+    uint32_t blocks;
+    bool truncated;
+};
+
+#endif  // ANT_CAPTURE_H
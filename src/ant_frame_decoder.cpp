@@ -0,0 +1,144 @@
+#include "ant_frame_decoder.h"
+#include "logger.h"
+#include "metrics.h"
+
+static inline bool isSyncByte(uint8_t b) {
+    return b == ANT_SYNC_BYTE || b == CMD_SYNC_BYTE;
+}
+
+ANTFrameDecoder::ANTFrameDecoder() {
+    reset();
+    stats = {};
+}
+
+void ANTFrameDecoder::reset() {
+    state = State::Hunting;
+    stashLen = 0;
+}
+
+ANTFrameDecoder::Check ANTFrameDecoder::checkFrame(const uint8_t *frame, size_t available) const {
+    if (available < 3) return Check::Incomplete;
+
+    uint8_t length = frame[2];
+    if (length == 0 || length > ANT_FRAME_MAX_PAYLOAD) return Check::BadLength;
+    if (available < (size_t)length + ANT_FRAME_OVERHEAD) return Check::Incomplete;
+
+    // ✅ XOR over the payload only, same as DeviceScanner/scanner.py
+    uint8_t crc = 0;
+    const uint8_t *payload = frame + 3;
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= payload[i];
+    }
+    return crc == payload[length] ? Check::Valid : Check::BadCrc;
+}
+
+void ANTFrameDecoder::emit(const uint8_t *frame, FrameHandler handler, void *context) {
+    ANTFrame decoded;
+    decoded.sync = frame[0];
+    decoded.deviceType = frame[1];
+    decoded.length = frame[2];
+    decoded.payload = frame + 3;
+
+    stats.frames++;
+    handler(context, decoded);
+}
+
+// ✅ Remove `count` bytes from the front of the stash, then anything up to the next sync byte
+void ANTFrameDecoder::dropStashBytes(uint8_t count) {
+    while (count < stashLen && !isSyncByte(stash[count])) {
+        count++;
+        stats.skippedBytes++;
+    }
+
+    if (count >= stashLen) {
+        stashLen = 0;
+        state = State::Hunting;
+        return;
+    }
+
+    memmove(stash, stash + count, stashLen - count);
+    stashLen -= count;
+}
+
+// ✅ Complete (or reject) the frame held in the stash using bytes from `data`.
+// Returns how many bytes of `data` were moved into the stash.
+size_t ANTFrameDecoder::continueStash(const uint8_t *data, size_t len, FrameHandler handler, void *context) {
+    size_t used = 0;
+
+    while (state == State::Assembling) {
+        switch (checkFrame(stash, stashLen)) {
+            case Check::Incomplete: {
+                if (used == len) return used;
+
+                size_t needed = (stashLen < 3) ? 3 - stashLen : stash[2] + ANT_FRAME_OVERHEAD - stashLen;
+                size_t n = (len - used < needed) ? len - used : needed;
+                memcpy(stash + stashLen, data + used, n);
+                stashLen += n;
+                used += n;
+                break;
+            }
+
+            case Check::Valid:
+                emit(stash, handler, context);
+                dropStashBytes(stash[2] + ANT_FRAME_OVERHEAD);
+                break;
+
+            case Check::BadLength:
+                stats.lengthErrors++;
+                dropStashBytes(1);
+                break;
+
+            case Check::BadCrc:
+                LOG("[ERROR] CRC Mismatch! Frame discarded, resyncing.");
+                stats.crcErrors++;
+                metrics.increment(METRIC_CRC_FAILURES);
+                dropStashBytes(1);
+                break;
+        }
+    }
+    return used;
+}
+
+void ANTFrameDecoder::feed(const uint8_t *data, size_t len, FrameHandler handler, void *context) {
+    size_t pos = 0;
+
+    if (state == State::Assembling) {
+        pos = continueStash(data, len, handler, context);
+    }
+
+    while (pos < len) {
+        const uint8_t *frame = data + pos;
+        size_t available = len - pos;
+
+        if (!isSyncByte(*frame)) {
+            stats.skippedBytes++;
+            pos++;
+            continue;
+        }
+
+        switch (checkFrame(frame, available)) {
+            case Check::Valid:
+                emit(frame, handler, context);  // ✅ Zero-copy: payload points into `data`
+                pos += frame[2] + ANT_FRAME_OVERHEAD;
+                break;
+
+            case Check::Incomplete:
+                memcpy(stash, frame, available);
+                stashLen = available;
+                state = State::Assembling;
+                return;
+
+            case Check::BadLength:
+                stats.lengthErrors++;
+                pos++;  // Resync on the next sync byte instead of dropping the batch
+                break;
+
+            case Check::BadCrc:
+                LOG("[ERROR] CRC Mismatch! Frame discarded, resyncing.");
+                stats.crcErrors++;
+                metrics.increment(METRIC_CRC_FAILURES);
+                pos++;
+                break;
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef ANT_FRAME_DECODER_H
+#define ANT_FRAME_DECODER_H
+
+#include <Arduino.h>
+
+// Serial frame layout: sync | deviceType | length | payload[length] | xor(payload)
+#define ANT_SYNC_BYTE 0xA4
+#define CMD_SYNC_BYTE 0xF0
+#define ANT_FRAME_OVERHEAD 4
+#define ANT_FRAME_MAX_PAYLOAD 32
+
+// ✅ A decoded frame. `payload` points into the caller's receive buffer whenever the
+// frame arrived in one piece, and into the decoder's own stash only when it straddled
+// two feed() calls. It is valid for the duration of the handler call only.
+struct ANTFrame {
+    uint8_t sync;
+    uint8_t deviceType;
+    uint8_t length;
+    const uint8_t *payload;
+};
+
+struct ANTFrameDecoderStats {
+    uint32_t frames;
+    uint32_t crcErrors;
+    uint32_t lengthErrors;
+    uint32_t skippedBytes;  // Bytes discarded while hunting for a sync byte
+};
+
+class ANTFrameDecoder {
+public:
+    typedef void (*FrameHandler)(void *context, const ANTFrame &frame);
+
+    ANTFrameDecoder();
+
+    // Decode every complete frame in `data`, calling `handler` for each one. A trailing
+    // partial frame is kept and completed by the next call. Bad lengths or checksums
+    // resync on the byte after the rejected sync byte, so the rest of the batch is kept.
+    void feed(const uint8_t *data, size_t len, FrameHandler handler, void *context);
+    void reset();
+
+    const ANTFrameDecoderStats &getStats() const { return stats; }
+
+private:
+    enum class State : uint8_t {
+        Hunting,     // Looking for a sync byte in the caller's buffer
+        Assembling   // A partial frame is held in `stash`
+    };
+
+    // Result of looking at a candidate frame starting at a sync byte
+    enum class Check : uint8_t { Valid, Incomplete, BadLength, BadCrc };
+
+    Check checkFrame(const uint8_t *frame, size_t available) const;
+    size_t continueStash(const uint8_t *data, size_t len, FrameHandler handler, void *context);
+    void dropStashBytes(uint8_t count);
+    void emit(const uint8_t *frame, FrameHandler handler, void *context);
+
+    State state;
+    uint8_t stash[ANT_FRAME_MAX_PAYLOAD + ANT_FRAME_OVERHEAD];
+    uint8_t stashLen;
+    ANTFrameDecoderStats stats;
+};
+
+#endif  // ANT_FRAME_DECODER_H
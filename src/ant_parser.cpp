@@ -1,7 +1,11 @@
 #include "ant_parser.h"
 #include "logger.h"
 #include "global.h"
+#include "serial_ingest.h"
+#include "websocket_ingest.h"
+#include "metrics.h"
 #include <NimBLEDevice.h>
+#include <array>
 
 // ANT+ Fitness Equipment Data Pages
 #define PAGE_GENERAL_FE_DATA 0x10
@@ -13,112 +17,229 @@
 #define PAGE_BATTERY_STATUS 0x52  // Page 82
 #define PAGE_POWER_ONLY_MAIN_DATA 0x10  // Page 10 (bike)
 
-ANTParser::ANTParser() {
+#define FE_CAPABILITY_DISTANCE 0x04  // Page 0x10 byte 7: distance traveled is reported
+
+#define ANT_PAGE_LENGTH 8  // Every ANT+ data page is 8 bytes
+
+ANTParser::ANTParser() : resetRequested(false), sessionResetRequested(false), serialLinkVersion(SERIAL_LINK_V1) {
     ftmsData = {};  // Initialize all values to defaults
     newData = false;
+    dirty = false;
+    commandHandler = nullptr;
+    frameTap = nullptr;
+    batchSource = CAPTURE_SOURCE_SERIAL;
+    memset(unhandledPages, 0, sizeof(unhandledPages));
+    unknownDeviceFrames = 0;
+    lastFrameUs = 0;
+    wheelCircumferenceMm = DEFAULT_WHEEL_CIRCUMFERENCE_MM;
 }
 
-void ANTParser::processANTMessage(uint8_t *data, uint8_t length, DeviceType deviceType) {
-    uint8_t page = data[0];
+void ANTParser::begin() {
+    preferences.begin("ble_ftms", true);
+    uint16_t wheel = preferences.getUShort("wheel_mm", DEFAULT_WHEEL_CIRCUMFERENCE_MM);
+    preferences.end();
+    setWheelCircumference(wheel, false);
+}
 
-    if (page >= 0x50 && page <= 0x54) { // Common Data Pages
-        parseCommonDataPage(data);
-        ftmsData.hasData = true;
-        newData = true;
+bool ANTParser::setWheelCircumference(uint16_t millimeters, bool persist) {
+    if (millimeters < MIN_WHEEL_CIRCUMFERENCE_MM || millimeters > MAX_WHEEL_CIRCUMFERENCE_MM) {
+        LOGF("[ERROR] Invalid wheel circumference: %d mm", millimeters);
+        return false;
+    }
+    wheelCircumferenceMm = millimeters;
+
+    if (persist) {
+        preferences.begin("ble_ftms", false);
+        preferences.putUShort("wheel_mm", millimeters);
+        preferences.end();
+    }
+    LOGF("[INFO] Wheel circumference: %d mm", millimeters);
+    return true;
+}
+
+// ✅ Dispatch table: one row per (device type, page) the parser understands.
+// To support a new profile or page, add its handler here; nothing else changes.
+#define ANT_ANY_PAGE -1  // Device type uses the same layout on every page
+#define ANT_ANY_DEVICE DeviceType::Unknown  // Common page, valid for every paged device type
+
+struct ANTParser::PageTable {
+    typedef void (ANTParser::*Handler)(const uint8_t *data);
+    struct Route {
+        DeviceType type;
+        int16_t page;
+        Handler handler;
+    };
+
+    static constexpr Route routes[] = {
+        { DeviceType::FitnessEquipment, PAGE_GENERAL_FE_DATA, &ANTParser::parseGeneralFeData },
+        { DeviceType::FitnessEquipment, PAGE_TRAINER_DATA, &ANTParser::parseTrainerData },
+        { DeviceType::FitnessEquipment, PAGE_TRAINER_STATUS, &ANTParser::parseTrainerStatus },
+        { DeviceType::PowerMeter, PAGE_POWER_ONLY_MAIN_DATA, &ANTParser::parsePowerMeterData },
+        { DeviceType::HeartRate, ANT_ANY_PAGE, &ANTParser::parseHeartRateData },        // Same layout for every HR page
+        { DeviceType::BikeCadence, ANT_ANY_PAGE, &ANTParser::parseBikeCadenceData },    // Bytes 4-7: crank event on every page
+        { DeviceType::BikeSpeed, ANT_ANY_PAGE, &ANTParser::parseBikeSpeedData },        // Bytes 4-7: wheel event on every page
+        { DeviceType::CombinedSpeedCadence, ANT_ANY_PAGE, &ANTParser::parseCombinedSpeedCadenceData },  // No page byte
+        { ANT_ANY_DEVICE, PAGE_MANUFACTURER_ID, &ANTParser::parseManufacturerID },
+        { ANT_ANY_DEVICE, PAGE_PRODUCT_INFO, &ANTParser::parseProductInfo },
+        { ANT_ANY_DEVICE, PAGE_BATTERY_STATUS, &ANTParser::parseBatteryStatus },
+        { ANT_ANY_DEVICE, PAGE_FE_Capabilities, &ANTParser::parseFECapabilities },
+    };
+};
+
+namespace {
+
+constexpr uint8_t ANT_NO_SLOT = 0xFF;
+constexpr uint8_t ANT_ROUTE_NONE = 0;  // Index entries hold route number + 1
+constexpr size_t ANT_ROUTE_COUNT = sizeof(ANTParser::PageTable::routes) / sizeof(ANTParser::PageTable::routes[0]);
+static_assert(ANT_ROUTE_COUNT < 0xFF, "Route numbers must fit in a uint8_t index entry");
+
+// Row of the page index for each device type the parser handles
+constexpr uint8_t deviceSlot(DeviceType type) {
+    switch (type) {
+        case DeviceType::FitnessEquipment: return 0;
+        case DeviceType::PowerMeter: return 1;
+        case DeviceType::HeartRate: return 2;
+        case DeviceType::BikeCadence: return 3;
+        case DeviceType::BikeSpeed: return 4;
+        case DeviceType::CombinedSpeedCadence: return 5;
+        default: return ANT_NO_SLOT;
+    }
+}
+constexpr uint8_t ANT_SLOT_COUNT = 6;
+constexpr DeviceType ANT_SLOT_TYPES[ANT_SLOT_COUNT] = {
+    DeviceType::FitnessEquipment, DeviceType::PowerMeter, DeviceType::HeartRate,
+    DeviceType::BikeCadence, DeviceType::BikeSpeed, DeviceType::CombinedSpeedCadence,
+};
+
+typedef std::array<std::array<uint8_t, 256>, ANT_SLOT_COUNT> PageIndex;
+
+// ✅ Expands the route list into a flat [device][page] → route lookup at compile time.
+// Precedence: any-page routes, then common pages, then exact (device, page) routes.
+constexpr PageIndex buildPageIndex() {
+    PageIndex index = {};
+    for (size_t r = 0; r < ANT_ROUTE_COUNT; r++) {
+        const ANTParser::PageTable::Route &route = ANTParser::PageTable::routes[r];
+        if (route.page != ANT_ANY_PAGE) continue;
+        for (size_t page = 0; page < 256; page++) index[deviceSlot(route.type)][page] = r + 1;
+    }
+    for (size_t r = 0; r < ANT_ROUTE_COUNT; r++) {
+        const ANTParser::PageTable::Route &route = ANTParser::PageTable::routes[r];
+        if (route.type != ANT_ANY_DEVICE) continue;
+        for (uint8_t slot = 0; slot < ANT_SLOT_COUNT; slot++) {
+            // Combined speed/cadence pages have no page number byte; byte 0 is event time
+            if (ANT_SLOT_TYPES[slot] == DeviceType::CombinedSpeedCadence) continue;
+            index[slot][route.page] = r + 1;
+        }
+    }
+    for (size_t r = 0; r < ANT_ROUTE_COUNT; r++) {
+        const ANTParser::PageTable::Route &route = ANTParser::PageTable::routes[r];
+        if (route.type == ANT_ANY_DEVICE || route.page == ANT_ANY_PAGE) continue;
+        index[deviceSlot(route.type)][route.page] = r + 1;
+    }
+    return index;
+}
+
+constexpr PageIndex ANT_PAGE_INDEX = buildPageIndex();
+
+static_assert(ANT_PAGE_INDEX[deviceSlot(DeviceType::FitnessEquipment)][PAGE_TRAINER_DATA] != ANT_ROUTE_NONE,
+              "FE trainer page must be routed");
+static_assert(ANT_PAGE_INDEX[deviceSlot(DeviceType::CombinedSpeedCadence)][PAGE_MANUFACTURER_ID] ==
+                  ANT_PAGE_INDEX[deviceSlot(DeviceType::CombinedSpeedCadence)][0],
+              "Combined speed/cadence must never take the common page route");
+
+}  // namespace
+
+void ANTParser::processANTMessage(const uint8_t *data, uint8_t length, DeviceType deviceType) {
+    if (length < ANT_PAGE_LENGTH) {
+        LOGF("[WARN] Short ANT+ Page: %d bytes", length);
         return;
     }
 
-    switch (deviceType) {
-        case DeviceType::FitnessEquipment:
-            switch (page) {
-                case PAGE_GENERAL_FE_DATA:
-                    parseGeneralFeData(data);
-                    break;
-                case PAGE_TRAINER_DATA:
-                    parseTrainerData(data);
-                    break;
-                case PAGE_TRAINER_STATUS:
-                    parseTrainerStatus(data);
-                    break;
-                default:
-                    LOGF("[WARN] Unhandled ANT+ Page (FE): 0x%02X", page);
-                    return;
-            }
-            break;
-
-        case DeviceType::PowerMeter:
-            switch (page) {
-                case PAGE_POWER_ONLY_MAIN_DATA:  // Example Power Data Page
-                    parsePowerMeterData(data);
-                    break;
-                default:
-                    LOGF("[WARN] Unhandled ANT+ Page (PowerMeter): 0x%02X", page);
-                    return;
-            }
-            break;
-
-        case DeviceType::BikeCadence:
-            switch (page) {
-                case 0x01:  // Bike Cadence Data Page
-                    //TODO: parseBikeCadenceData(data);
-                    break;
-                default:
-                    LOGF("[WARN] Unhandled ANT+ Page (BikeCadence): 0x%02X", page);
-                    return;
-            }
-            break;
-
-        default:
-            LOGF("[ERROR] Unknown device type: %d", deviceType);
-            return;
+    uint8_t slot = deviceSlot(deviceType);
+    if (slot == ANT_NO_SLOT) {
+        metrics.increment(METRIC_UNKNOWN_PAGES_OTHER);
+        if (unknownDeviceFrames++ == 0) LOGF("[WARN] Unknown device type: %d", (int)deviceType);
+        return;
     }
 
+    uint8_t page = data[0];
+    uint8_t route = ANT_PAGE_INDEX[slot][page];
+    if (route == ANT_ROUTE_NONE) {
+        // ✅ Count, don't format: log only the first time a page shows up
+        metrics.increment(unknownPagesCounter(deviceType));
+        if (unhandledPages[page]++ == 0) LOGF("[WARN] Unhandled ANT+ Page 0x%02X (type %d)", page, (int)deviceType);
+        return;
+    }
+    (this->*PageTable::routes[route - 1].handler)(data);
+
     // ✅ Mark data as valid once any valid ANT+ message is received
     ftmsData.hasData = true;
     newData = true;
+    dirty = true;
+}
+
+uint32_t ANTParser::getUnhandledPageTotal() const {
+    uint32_t total = 0;
+    for (uint16_t page = 0; page < 256; page++) total += unhandledPages[page];
+    return total;
 }
 
 
 FTMSDataStorage ANTParser::getFTMSData() {
-    return ftmsData;
+    if (resetRequested.load(std::memory_order_acquire)) {
+        return FTMSDataStorage();  // Reset pending: don't hand out the old session
+    }
+    return snapshot.read();
 }
 
-void ANTParser::resetFTMData() {
-    ftmsData = {};  // Reset all fields to default values
+// ✅ True once per batch of updates: reading the flag clears it
+bool ANTParser::hasNewData() {
+    bool fresh = newData;
     newData = false;
+    return fresh;
+}
+
+void ANTParser::resetFTMData() {
+    resetRequested.store(true, std::memory_order_release);
+}
+
+void ANTParser::resetSession() {
+    sessionResetRequested.store(true, std::memory_order_release);
 }
 
 void ANTParser::parseGeneralFeData(const uint8_t* data) {
     // ✅ Extract Equipment Type
     uint8_t equipmentType = data[1];  
 
-    // ✅ Convert Elapsed Time
-    ftmsData.elapsed_time = (data[2] == 0xFF) ? 0 : data[2] * 0.25;  
-
-    // ✅ Convert Distance
-    ftmsData.distance = (data[3] == 0xFF) ? 0 : data[3];
+    // ✅ Elapsed Time (0.25 s, wraps every 64 s) and Distance (m, wraps every 256 m)
+    // are extended into session totals; applyFusion() copies them into ftmsData
+    session.updateElapsed(data[2], batchMs);
+    if (data[7] & FE_CAPABILITY_DISTANCE) session.updateDistance(data[3], ftmsData.speed, batchMs);
 
     // ✅ Correct Speed Extraction (Little-Endian)
     uint16_t rawSpeed = data[4] | (data[5] << 8);
-    ftmsData.speed = (rawSpeed == 0xFFFF) ? 0.0 : (rawSpeed * 0.001 * 3.6);
+    float speed = (rawSpeed == 0xFFFF) ? 0.0 : (rawSpeed * 0.001 * 3.6);
+    if (rawSpeed != 0xFFFF) fusion.update(DeviceType::FitnessEquipment, ANT_DEVICE_NUMBER_ANY, Metric::Speed, speed, batchMs);
 
     // ✅ Extract Heart Rate
-    ftmsData.heart_rate = (data[6] == 0xFF) ? 0 : data[6];
+    uint8_t heartRate = (data[6] == 0xFF) ? 0 : data[6];
+    if (data[6] != 0xFF) fusion.update(DeviceType::FitnessEquipment, ANT_DEVICE_NUMBER_ANY, Metric::HeartRate, heartRate, batchMs);
 
     // ✅ Extract Capabilities and FE State
     uint8_t capabilities = data[7] & 0x0F;  // Bits 0-3
     ftmsData.fe_state = (data[7] >> 4);  // Bits 4-7
 
     // ✅ Debug Output
-    LOGF("[ANT+] General FE Data - Equipment: %d, Speed: %.2f km/h, Distance: %d m, HR: %d, State: %d",
-         equipmentType, ftmsData.speed, ftmsData.distance, ftmsData.heart_rate, ftmsData.fe_state);
+    LOGF("[ANT+] General FE Data - Equipment: %d, Speed: %.2f km/h, Distance: %u m, HR: %d, State: %d",
+         equipmentType, speed, session.distanceMeters.total, heartRate, ftmsData.fe_state);
 }
 
 
 
 void ANTParser::parseTrainerData(const uint8_t* data) {
     // ✅ Extract Instantaneous Cadence (Byte 2)
-    ftmsData.cadence = (data[2] == 0xFF) ? 0 : data[2];
+    uint8_t cadence = (data[2] == 0xFF) ? 0 : data[2];
+    if (data[2] != 0xFF) fusion.update(DeviceType::FitnessEquipment, ANT_DEVICE_NUMBER_ANY, Metric::Cadence, cadence, batchMs);
 
     // ✅ Extract Accumulated Power (Bytes 3-4, Little-Endian)
     uint16_t accumulatedPower = data[3] | (data[4] << 8);
@@ -126,7 +247,14 @@ void ANTParser::parseTrainerData(const uint8_t* data) {
 
     // ✅ Extract Instantaneous Power (12-bit, LSB in Byte 5, MSB upper 4 bits of Byte 6)
     uint16_t instantaneousPower = (data[5] | ((data[6] & 0x0F) << 8));
-    ftmsData.instantaneous_power = (instantaneousPower == 0xFFF) ? 0 : instantaneousPower;
+    if (instantaneousPower != 0xFFF) {
+        // ✅ Event count (Byte 1) + accumulated power give the true average between pages
+        trainerPower.update(data[1], accumulatedPower, batchMs);
+        if (trainerPower.isCoasting(batchMs)) instantaneousPower = 0;
+        fusion.update(DeviceType::FitnessEquipment, ANT_DEVICE_NUMBER_ANY, Metric::Power, instantaneousPower, batchMs);
+    } else {
+        instantaneousPower = 0;
+    }
 
     // ✅ Extract Trainer Status (Bits 4-7 of Byte 6)
     ftmsData.trainer_status = (data[6] & 0x07);
@@ -137,13 +265,13 @@ void ANTParser::parseTrainerData(const uint8_t* data) {
     ftmsData.fe_state = (data[7] >> 4);
 
     LOGF("[ANT+] Trainer Data - Power: %d W, Cadence: %d rpm, Accumulated Power: %d W, Status: %d, Virtual Speed: %d, FE State: %d",
-         ftmsData.instantaneous_power, ftmsData.cadence, ftmsData.accumulated_power,
+         instantaneousPower, cadence, ftmsData.accumulated_power,
          ftmsData.trainer_status, ftmsData.virtual_speed, ftmsData.fe_state);
 }
 
 void ANTParser::parsePowerMeterData(const uint8_t* data) {
     // ✅ Extract Update Event Count (Byte 1)
-    //uint8_t eventCount = data[1];
+    uint8_t eventCount = data[1];
 
     // ✅ Extract Pedal Power Information (Byte 2)
     uint8_t pedalPowerRaw = data[2];
@@ -167,18 +295,73 @@ void ANTParser::parsePowerMeterData(const uint8_t* data) {
     uint16_t instantaneousPower = data[6] | (data[7] << 8);
     if (instantaneousPower == 0xFFFF) instantaneousPower = 0; // Invalid data check
 
-    // ✅ Store values in data structure
+    // ✅ Store values in data structure; power and cadence go through fusion
     ftmsData.is_right_pedal = isRightPedal;
     ftmsData.pedal_power_percent = pedalPowerPercent;
-    ftmsData.cadence = cadence;
     ftmsData.accumulated_power = accumulatedPower;
-    ftmsData.instantaneous_power = instantaneousPower;
+    if (data[3] != 0xFF) fusion.update(DeviceType::PowerMeter, ANT_DEVICE_NUMBER_ANY, Metric::Cadence, cadence, batchMs);
+    if (data[6] != 0xFF || data[7] != 0xFF) {
+        // ✅ Repeated event counts are duplicates; no new event for a while means coasting
+        powerMeterPower.update(eventCount, data[4] | (data[5] << 8), batchMs);  // Raw: 0xFFFF is a valid count
+        if (powerMeterPower.isCoasting(batchMs)) instantaneousPower = 0;
+        fusion.update(DeviceType::PowerMeter, ANT_DEVICE_NUMBER_ANY, Metric::Power, instantaneousPower, batchMs);
+    }
 
     // ✅ Debug Output
-    LOGF("[ANT+] Power Meter Data - Pedal: %s, Pedal Power: %d%%, Cadence: %d RPM, Accumulated Power: %d W, Instant Power: %d W",
-         isRightPedal ? "Right" : "Unknown", pedalPowerPercent, cadence, accumulatedPower, instantaneousPower);
+    LOGF("[ANT+] Power Meter Data - Events: %d, Pedal: %s, Pedal Power: %d%%, Cadence: %d RPM, Accumulated Power: %d W, Instant Power: %d W",
+         eventCount, isRightPedal ? "Right" : "Unknown", pedalPowerPercent, cadence, accumulatedPower, instantaneousPower);
+}
+
+
+void ANTParser::parseHeartRateData(const uint8_t* data) {
+    // ✅ Byte 7 is the computed heart rate on every HR data page (page number in bits 0-6)
+    uint8_t heartRate = data[7];
+    if (heartRate != 0) fusion.update(DeviceType::HeartRate, ANT_DEVICE_NUMBER_ANY, Metric::HeartRate, heartRate, batchMs);
+
+    LOGF("[ANT+] Heart Rate Data - Page: %d, HR: %d bpm", data[0] & 0x7F, heartRate);
+}
+
+void ANTParser::parseBikeCadenceData(const uint8_t* data) {
+    // ✅ Bytes 4-5: Cadence Event Time (1/1024 s), Bytes 6-7: Cumulative Crank Revolutions
+    uint16_t eventTime = data[4] | (data[5] << 8);
+    uint16_t revolutions = data[6] | (data[7] << 8);
+
+    cadenceSensor.update(eventTime, revolutions, batchMs);
+    fusion.update(DeviceType::BikeCadence, ANT_DEVICE_NUMBER_ANY, Metric::Cadence, cadenceSensor.rpm, batchMs);
+
+    LOGF("[ANT+] Bike Cadence - Page: %d, Event Time: %u, Revolutions: %u, Cadence: %.1f rpm",
+         data[0] & 0x7F, eventTime, revolutions, cadenceSensor.rpm);
 }
 
+void ANTParser::parseBikeSpeedData(const uint8_t* data) {
+    // ✅ Bytes 4-5: Speed Event Time (1/1024 s), Bytes 6-7: Cumulative Wheel Revolutions
+    uint16_t eventTime = data[4] | (data[5] << 8);
+    uint16_t revolutions = data[6] | (data[7] << 8);
+
+    speedSensor.update(eventTime, revolutions, batchMs);
+    float speed = wheelSpeedKmh(speedSensor.rpm, wheelCircumferenceMm);
+    fusion.update(DeviceType::BikeSpeed, ANT_DEVICE_NUMBER_ANY, Metric::Speed, speed, batchMs);
+
+    LOGF("[ANT+] Bike Speed - Page: %d, Event Time: %u, Revolutions: %u, Speed: %.2f km/h",
+         data[0] & 0x7F, eventTime, revolutions, speed);
+}
+
+void ANTParser::parseCombinedSpeedCadenceData(const uint8_t* data) {
+    // ✅ Single page: cadence time/revs in Bytes 0-3, speed time/revs in Bytes 4-7
+    uint16_t cadenceTime = data[0] | (data[1] << 8);
+    uint16_t crankRevs = data[2] | (data[3] << 8);
+    uint16_t speedTime = data[4] | (data[5] << 8);
+    uint16_t wheelRevs = data[6] | (data[7] << 8);
+
+    comboCadence.update(cadenceTime, crankRevs, batchMs);
+    comboSpeed.update(speedTime, wheelRevs, batchMs);
+    float speed = wheelSpeedKmh(comboSpeed.rpm, wheelCircumferenceMm);
+
+    fusion.update(DeviceType::CombinedSpeedCadence, ANT_DEVICE_NUMBER_ANY, Metric::Cadence, comboCadence.rpm, batchMs);
+    fusion.update(DeviceType::CombinedSpeedCadence, ANT_DEVICE_NUMBER_ANY, Metric::Speed, speed, batchMs);
+
+    LOGF("[ANT+] Speed/Cadence - Cadence: %.1f rpm, Speed: %.2f km/h", comboCadence.rpm, speed);
+}
 
 void ANTParser::parseTrainerStatus(const uint8_t* data) {
     // ✅ Reserved Fields (Ignore)
@@ -263,85 +446,138 @@ void ANTParser::parseProductInfo(const uint8_t* data) {
          ftmsData.softwareVersion, ftmsData.serialNumber);
 }
 
+// ✅ Decode straight out of the ring; at most two spans when the data wraps
+template <typename Ring, typename Decoder>
+void ANTParser::drain(Ring &ring, Decoder &frameDecoder, CaptureSource source) {
+    const uint8_t *span;
+    size_t n;
+    while ((n = ring.getReadable(&span)) > 0) {
+        ingest(frameDecoder, source, span, n);
+        ring.consume(n);
+    }
+}
+
+// ✅ A switch takes effect between batches. The Pi only sends v2 after the 'L' answer,
+// so whatever follows LINK V2 in the same batch is still v1.
+bool ANTParser::setSerialLinkVersion(uint8_t version) {
+    if (version != SERIAL_LINK_V1 && version != SERIAL_LINK_V2) {
+        LOGF("[ERROR] Invalid serial link version: %u", version);
+        return false;
+    }
+    if (version != serialLinkVersion.load(std::memory_order_relaxed)) {
+        decoder.reset();
+        linkDecoder.reset();
+        serialLinkVersion.store(version, std::memory_order_relaxed);
+        LOGF("[INFO] Serial link now v%u", version);
+    }
+    return true;
+}
+
 void ANTParser::readSerial() {
-    static uint8_t buffer[32];  // Buffer for ANT+ and custom messages
-    static uint8_t index = 0;
-    static uint8_t expectedLength = 0;
-    static bool receiving = false;
-
-    while (Serial.available()) {
-        uint8_t byteReceived = Serial.read();
-
-        if (!receiving) {
-            if (byteReceived == 0xA4 || byteReceived == 0xF0) {  // ANT+ or Custom Sync Byte
-                index = 0;
-                receiving = true;
-                expectedLength = 0;
-                buffer[index++] = byteReceived;
-            }
-            continue;
+    if (getSerialLinkVersion() == SERIAL_LINK_V1) {
+        drain(serialIngest.getRing(), decoder, CAPTURE_SOURCE_SERIAL);
+    } else {
+        drain(serialIngest.getRing(), linkDecoder, CAPTURE_SOURCE_SERIAL);
+        if (linkDecoder.getConsecutiveErrors() >= LINK_V2_FALLBACK_ERRORS) {
+            LOG("[WARN] Serial link v2: no valid packet in a while, back to v1");
+            setSerialLinkVersion(SERIAL_LINK_V1);
         }
+    }
+    serialIngest.resume();  // ✅ Bytes a full ring left in the UART driver, now there's room
+}
 
-        buffer[index++] = byteReceived;
+void ANTParser::readWebSocket() {
+    drain(wsIngest.getRing(), wsDecoder, CAPTURE_SOURCE_WEBSOCKET);
+}
 
-        // ✅ Adjusted expected length calculation (extra device_type byte)
-        if (index == 3) {
-            expectedLength = buffer[2] + 4;  // Length Byte now at buffer[2], includes device_type
-        }
+void ANTParser::ingest(const uint8_t *data, size_t len) {
+    if (getSerialLinkVersion() == SERIAL_LINK_V1) ingest(decoder, CAPTURE_SOURCE_SERIAL, data, len);
+    else ingest(linkDecoder, CAPTURE_SOURCE_SERIAL, data, len);
+}
 
-        // ✅ Process message only when full length is received
-        if (index == expectedLength) {
-            // ✅ Validate CRC (updated offsets)
-            if (!validateCRC(buffer + 3, index - 4, buffer[index - 1])) {  // Adjusted for device_type
-                LOG("[ERROR] CRC Mismatch! Message Discarded.");
-                index = 0;
-                receiving = false;
-                return;
-            }
-
-            // ✅ Extract Device Type from new position (buffer[1])
-            DeviceType deviceType = static_cast<DeviceType>(buffer[1]);
-
-            // ✅ Extract payload correctly (adjusted for extra byte)
-            uint8_t payloadLength = buffer[2];  // Length now at buffer[2]
-            uint8_t processedMessage[payloadLength];
-
-            for (uint8_t i = 0; i < payloadLength; i++) {
-                processedMessage[i] = buffer[i + 3];  // Adjusted for device_type byte
-            }
-
-            // ✅ Detect and process ANT+ or Custom Serial Messages
-            if (buffer[0] == 0xF0) {
-                processSerialCommand(processedMessage, payloadLength);
-            } else {
-                processANTMessage(processedMessage, payloadLength, deviceType);
-            }
-
-            index = 0;
-            receiving = false;
-        }
+template <typename Decoder>
+void ANTParser::ingest(Decoder &frameDecoder, CaptureSource source, const uint8_t *data, size_t len) {
+    // ✅ Apply a reset requested from another task before decoding anything new
+    if (resetRequested.load(std::memory_order_acquire)) {
+        ftmsData = {};  // Reset all fields to default values
+        fusion.reset();
+        powerMeterPower.reset();
+        trainerPower.reset();
+        cadenceSensor.reset();
+        speedSensor.reset();
+        comboCadence.reset();
+        comboSpeed.reset();
+        session.resume();  // ✅ Ride totals outlive a data reset (BLE reconnect)
+        session.apply(ftmsData);
+        newData = false;
+        snapshot.write(ftmsData);
+        resetRequested.store(false, std::memory_order_release);
+    }
+    if (sessionResetRequested.load(std::memory_order_acquire)) {
+        session.reset();
+        session.apply(ftmsData);
+        snapshot.write(ftmsData);
+        sessionResetRequested.store(false, std::memory_order_release);
     }
-}
 
-bool ANTParser::validateCRC(uint8_t *payload, uint8_t length, uint8_t expectedCRC) {
-    uint8_t calculatedCRC = 0;
+    batchMs = millis();
+    batchSource = source;
+    frameDecoder.feed(data, len, &ANTParser::onFrame, this);
 
-    // ✅ XOR all bytes in the payload (starting from `payload[0]`)
-    for (uint8_t i = 0; i < length; i++) {  // ✅ Start at 0, stop at last payload byte
-        calculatedCRC ^= payload[i];  // XOR each byte
+    // ✅ One published version per batch, so a burst of pages lands atomically
+    if (dirty) {
+        applyFusion(batchMs);
+        snapshot.write(ftmsData);
+        dirty = false;
     }
+}
 
-    if (!(calculatedCRC == expectedCRC)) {
-        LOGF("[DEBUG] Calculated CRC: 0x%02X, Expected CRC: 0x%02X", calculatedCRC, expectedCRC);
+// ✅ Re-run fusion without new frames so sensors that went silent drop out
+void ANTParser::refresh() {
+    if (applyFusion(millis())) {
+        snapshot.write(ftmsData);
+        newData = true;
     }
+}
+
+// ✅ Fused metrics, plus the power totals of whichever source fusion picked for power
+bool ANTParser::applyFusion(uint32_t nowMs) {
+    bool changed = fusion.apply(ftmsData, nowMs);
+
+    DeviceType source = fusion.getSelectedSource(Metric::Power);
+    const PowerAccumulator *totals = nullptr;
+    if (source == DeviceType::PowerMeter) totals = &powerMeterPower;
+    else if (source == DeviceType::FitnessEquipment) totals = &trainerPower;
 
-    //LOGF("[DEBUG] Calculated CRC: 0x%02X, Expected CRC: 0x%02X", calculatedCRC, expectedCRC);
-    //LOG("");
-    return (calculatedCRC == expectedCRC);
+    ftmsData.power_source = totals ? source : DeviceType::Unknown;
+    ftmsData.power_event_total = totals ? totals->eventTotal : 0;
+    ftmsData.power_accumulated_total = totals ? totals->powerTotal : 0;
+
+    session.updatePower(ftmsData, nowMs);
+    session.apply(ftmsData);
+    return changed;
 }
 
+void ANTParser::onFrame(void *context, const ANTFrame &frame) {
+    ANTParser *parser = static_cast<ANTParser *>(context);
+
+    uint32_t arrivalUs = micros();
+    uint32_t start = metrics.spanStart();
+    metrics.increment(METRIC_FRAMES_RECEIVED);
+    if (parser->lastFrameUs) metrics.record(METRIC_FRAME_INTERARRIVAL, arrivalUs - parser->lastFrameUs);
+    parser->lastFrameUs = arrivalUs;
+    if (parser->frameTap) parser->frameTap(frame, parser->batchSource, arrivalUs);
 
-void ANTParser::processSerialCommand(uint8_t *data, uint8_t length) {
+    // ✅ Detect and process ANT+ or Custom Serial Messages
+    if (frame.sync == CMD_SYNC_BYTE) {
+        parser->processSerialCommand(frame.payload, frame.length);
+        return;  // Commands may block (flash writes); keep them out of the parse histogram
+    }
+    parser->processANTMessage(frame.payload, frame.length, static_cast<DeviceType>(frame.deviceType));
+    metrics.record(METRIC_PARSE_TIME, metrics.spanUs(start));
+}
+
+void ANTParser::processSerialCommand(const uint8_t *data, uint8_t length) {
     if (length < 2) {  // Ensure there's a valid payload
         LOG("[ERROR] Invalid Serial Command: Too Short");
         return;
@@ -370,46 +606,31 @@ void ANTParser::processSerialCommand(uint8_t *data, uint8_t length) {
         LOG("[INFO] Rebooting to apply changes...");
         delay(500);
         esp_restart();
+    } else if (command.startsWith("WHEEL ")) {
+        // ✅ Range-checked before narrowing: "67536" must not wrap into a valid wheel
+        String value = command.substring(6);
+        char *end;
+        unsigned long millimeters = strtoul(value.c_str(), &end, 10);
+        if (end == value.c_str() || *end != '\0' || millimeters < MIN_WHEEL_CIRCUMFERENCE_MM ||
+            millimeters > MAX_WHEEL_CIRCUMFERENCE_MM) {
+            LOGF("[ERROR] Invalid wheel circumference: %s", value.c_str());
+            return;
+        }
+        setWheelCircumference((uint16_t)millimeters);
     } else if (command == "REBOOT") {
         LOG("[INFO] Reboot command received! Restarting ESP32...");
         delay(500);
         esp_restart();
+    } else if (commandHandler && commandHandler(command)) {
+        // ✅ Handled by the application (e.g. NOTIFY)
     } else {
         LOGF("[ERROR] Unknown Command: %s", command.c_str());
     }
 }
 
-void ANTParser::parseCommonDataPage(const uint8_t* data) {
-    uint8_t page = data[0];
-
-    switch (page) {
-        case PAGE_MANUFACTURER_ID: { // Manufacturer ID
-            parseManufacturerID(data);
-            break;
-        }
-
-        case PAGE_PRODUCT_INFO: { // Product Info (Software/Hardware)
-            parseProductInfo(data);
-            break;
-        }
-
-        case PAGE_BATTERY_STATUS: { // Battery Status
-            uint8_t batteryID = data[3];
-            uint8_t batteryVoltage = data[4];
-            ftmsData.batteryStatus = batteryVoltage;
-            LOGF("[ANT+] Battery Data: ID: %d, Voltage: %d", batteryID, batteryVoltage);
-            break;
-        }
-
-        case PAGE_FE_Capabilities: { // FE Capabilities
-            parseFECapabilities(data);
-            break;
-        }
-
-        default:
-            LOGF("[WARN] Unknown Common Data Page: 0x%02X", page);
-            return;
-    }
+void ANTParser::parseBatteryStatus(const uint8_t* data) {
+    uint8_t batteryID = data[3];
+    uint8_t batteryVoltage = data[4];
+    ftmsData.batteryStatus = batteryVoltage;
+    LOGF("[ANT+] Battery Data: ID: %d, Voltage: %d", batteryID, batteryVoltage);
 }
-
-
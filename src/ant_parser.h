@@ -2,75 +2,105 @@
 #define ANT_PARSER_H
 
 #include <Arduino.h>
+#include "ant_frame_decoder.h"
+#include "ant_capture.h"
+#include "serial_link_v2.h"
+#include "seqlock.h"
+#include "ftms_data.h"
+#include "sensor_fusion.h"
+#include "power_accumulator.h"
+#include "speed_cadence.h"
+#include "session_totals.h"
 
-enum class DeviceType {
-    Unknown = 0,
-    PowerMeter = 11,
-    FitnessEquipment = 17,
-    HeartRate = 120,
-    StrideSpeed = 124,
-    BikeCadence = 122,
-    BikeSpeed = 123,
-    CombinedSpeedCadence = 121
-};
-
-// ✅ Struct to store persistent FTMS data
-struct FTMSDataStorage {
-    uint16_t elapsed_time;
-    uint32_t distance; // Updated to 24-bit equivalent
-    float speed;
-    uint8_t heart_rate;
-    uint16_t power;
-    uint8_t virtual_speed; 
-    uint16_t accumulated_power;
-    uint16_t instantaneous_power;
-    uint8_t cadence;
-    float cycle_length;
-    float incline;
-    float resistance;
-    uint8_t fe_state;
-    uint16_t manufacturerID;
-    uint32_t serialNumber;
-    uint16_t softwareVersion;
-    uint16_t modelNumber;
-    uint8_t hardware_revision; 
-    uint8_t trainer_status;
-    uint16_t maxResistance;
-    uint8_t batteryStatus;
-    uint8_t pedal_power_percent;
-    bool is_right_pedal;
-    bool hasData;
-
-    FTMSDataStorage() : elapsed_time(0), distance(0), speed(0), heart_rate(0), power(0),
-                        accumulated_power(0), instantaneous_power(0), cadence(0), cycle_length(0),
-                        incline(0), resistance(0), fe_state(0), manufacturerID(0), serialNumber(0),
-                        softwareVersion(0), modelNumber(0), virtual_speed(0), hardware_revision(0), trainer_status(0), maxResistance(0), batteryStatus(255), pedal_power_percent(0), is_right_pedal(false), hasData(false) {}
-};
 class ANTParser {
     public:
+        // ✅ Gets 0xF0 commands the parser doesn't know; return true if handled
+        typedef bool (*CommandHandler)(const String &command);
+        // ✅ Sees every valid frame (parsing task) before it is dispatched
+        typedef void (*FrameTap)(const ANTFrame &frame, CaptureSource source, uint32_t arrivalUs);
+
         ANTParser();
-        void processANTMessage(uint8_t *data, uint8_t length, DeviceType deviceType);
-        FTMSDataStorage getFTMSData();  // ✅ Return collected FTMS data
-        void resetFTMData();
+        void begin();  // ✅ Load settings (wheel circumference) from preferences
+        FTMSDataStorage getFTMSData();  // ✅ Consistent snapshot, safe from any task
+        void resetFTMData();  // ✅ Safe from any task; applied by the parsing task. Keeps session totals
+        void resetSession();  // ✅ Safe from any task; zeroes elapsed time, distance and energy
         bool hasNewData();
-        void readSerial();
+        void readSerial();  // ✅ Legacy frames or v2 packets, whichever the link has negotiated
+        void readWebSocket();  // ✅ Frames the Pi pushed over /ws (WebSocketIngest ring)
+        void ingest(const uint8_t *data, size_t len);  // ✅ Decode raw serial bytes (serial decoder state)
+        void refresh();  // ✅ Expire stale sensors when no frames arrive (parsing task only)
+        const SensorFusion &getFusion() const { return fusion; }
+        const PowerAccumulator &getPowerMeterAccumulator() const { return powerMeterPower; }
+        const PowerAccumulator &getTrainerAccumulator() const { return trainerPower; }
+        const SessionTotals &getSessionTotals() const { return session; }
+        // ✅ WHEEL command / Preferences; set from the parsing task, read anywhere
+        bool setWheelCircumference(uint16_t millimeters, bool persist = true);
+        uint16_t getWheelCircumference() const { return wheelCircumferenceMm.load(std::memory_order_relaxed); }
+        const ANTFrameDecoderStats &getDecoderStats() const { return decoder.getStats(); }
+        const ANTFrameDecoderStats &getWebSocketDecoderStats() const { return wsDecoder.getStats(); }
+        const SerialLinkV2Stats &getLinkV2Stats() const { return linkDecoder.getStats(); }
+        // ✅ Serial framing (serial_link_v2.h); set from the parsing task, read anywhere
+        bool setSerialLinkVersion(uint8_t version);
+        uint8_t getSerialLinkVersion() const { return serialLinkVersion.load(std::memory_order_relaxed); }
+        void setCommandHandler(CommandHandler handler) { commandHandler = handler; }
+        void setFrameTap(FrameTap tap) { frameTap = tap; }
+        // ✅ Diagnostics: frames for pages/device types with no handler in the dispatch table
+        uint32_t getUnhandledPageCount(uint8_t page) const { return unhandledPages[page]; }
+        uint32_t getUnhandledPageTotal() const;
+        uint32_t getUnknownDeviceFrames() const { return unknownDeviceFrames; }
+
+        struct PageTable;  // ✅ constexpr (device type, page) → handler routes, see ant_parser.cpp
 
     private:
-        FTMSDataStorage ftmsData;  // ✅ Store collected data
+        FTMSDataStorage ftmsData;  // ✅ Working copy, only touched by the parsing task
+        SeqLock<FTMSDataStorage> snapshot;  // ✅ What readers see, published once per ingest()
+        std::atomic<bool> resetRequested;
+        std::atomic<bool> sessionResetRequested;
+        SensorFusion fusion;  // ✅ Per-sensor power/cadence/speed/HR, fused into ftmsData
+        PowerAccumulator powerMeterPower;  // ✅ Page 0x10 event count + accumulated power
+        PowerAccumulator trainerPower;     // ✅ Page 0x19 event count + accumulated power
+        RevolutionRate cadenceSensor;      // ✅ Device type 122
+        RevolutionRate speedSensor;        // ✅ Device type 123
+        RevolutionRate comboCadence;       // ✅ Device type 121, crank half
+        RevolutionRate comboSpeed;         // ✅ Device type 121, wheel half
+        SessionTotals session;             // ✅ Elapsed time, distance, energy of the ride
+        std::atomic<uint16_t> wheelCircumferenceMm;
+        bool applyFusion(uint32_t nowMs);  // Returns true if a fused metric changed
+        uint32_t batchMs;  // millis() of the batch being decoded
         bool newData;
-        bool validateCRC(uint8_t *payload, uint8_t length, uint8_t crc);
-        void processSerialCommand(uint8_t *data, uint8_t length);
+        bool dirty;
+        void processANTMessage(const uint8_t *data, uint8_t length, DeviceType deviceType);
+        ANTFrameDecoder decoder;    // ✅ One per transport, so partial frames never mix
+        ANTFrameDecoder wsDecoder;
+        SerialLinkV2Decoder linkDecoder;  // ✅ Serial bytes once v2 is negotiated
+        std::atomic<uint8_t> serialLinkVersion;
+        template <typename Decoder>
+        void ingest(Decoder &frameDecoder, CaptureSource source, const uint8_t *data, size_t len);
+        template <typename Ring, typename Decoder>
+        void drain(Ring &ring, Decoder &frameDecoder, CaptureSource source);
+        CommandHandler commandHandler;
+        FrameTap frameTap;
+        CaptureSource batchSource;  // Transport of the batch being decoded
+        static void onFrame(void *context, const ANTFrame &frame);
+        void processSerialCommand(const uint8_t *data, uint8_t length);
 
-        void parseCommonDataPage(const uint8_t *data);
+        uint32_t unhandledPages[256];  // ✅ Per-page histogram of frames nothing handled
+        uint32_t unknownDeviceFrames;
+        uint32_t lastFrameUs;  // ✅ micros() of the previous frame, for the inter-arrival histogram
 
         // ✅ Parsing functions now update only specific fields
         void parseGeneralFeData(const uint8_t* data);
         void parseTrainerData(const uint8_t* data);
         void parsePowerMeterData(const uint8_t *data);
+        void parseHeartRateData(const uint8_t *data);
+        void parseBikeCadenceData(const uint8_t *data);
+        void parseBikeSpeedData(const uint8_t *data);
+        void parseCombinedSpeedCadenceData(const uint8_t *data);
         void parseTrainerStatus(const uint8_t *data);
         void parseFECapabilities(const uint8_t *data);
         void parseManufacturerID(const uint8_t *data);
         void parseProductInfo(const uint8_t* data);
+        void parseBatteryStatus(const uint8_t* data);
 };
 
 #endif  // ANT_PARSER_H
@@ -0,0 +1,58 @@
+#include "ant_uplink.h"
+#include "ant_frame_decoder.h"
+#include "logger.h"
+
+#define ANT_UPLINK_RETRY_MS 1
+
+ANTUplink antUplink;
+
+ANTUplink::ANTUplink() : port(nullptr) {
+    stats = {};
+}
+
+void ANTUplink::begin(HardwareSerial &uart) {
+    port = &uart;
+}
+
+// ✅ A partial frame would desync the Pi's decoder: write all of it or nothing, and
+// only if at least `headroom` more bytes stay free after it
+bool ANTUplink::writeFrame(uint8_t sync, uint8_t type, const uint8_t *payload, uint8_t len, size_t headroom) {
+    if (!port || len == 0 || len > ANT_FRAME_MAX_PAYLOAD) return false;
+
+    uint8_t frame[ANT_FRAME_MAX_PAYLOAD + ANT_FRAME_OVERHEAD];
+    size_t frameLen = len + ANT_FRAME_OVERHEAD;
+    if (port->availableForWrite() < (int)(frameLen + headroom)) return false;
+
+    frame[0] = sync;
+    frame[1] = type;
+    frame[2] = len;
+
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        frame[3 + i] = payload[i];
+        crc ^= payload[i];
+    }
+    frame[frameLen - 1] = crc;
+    port->write(frame, frameLen);
+
+    stats.frames++;
+    stats.bytes += frameLen;
+    return true;
+}
+
+bool ANTUplink::sendPage(DeviceType deviceType, const uint8_t *page) {
+    if (!writeFrame(ANT_SYNC_BYTE, (uint8_t)deviceType, page, ANT_UPLINK_PAGE_LENGTH, 0)) {
+        stats.stalls++;
+        return false;
+    }
+    return true;
+}
+
+bool ANTUplink::sendCommand(uint8_t type, const uint8_t *payload, uint8_t len, uint32_t timeoutMs) {
+    uint32_t startMs = millis();
+    while (!writeFrame(CMD_SYNC_BYTE, type, payload, len, ANT_UPLINK_PAGE_LENGTH + ANT_FRAME_OVERHEAD)) {
+        if (!port || millis() - startMs >= timeoutMs) return false;
+        delay(ANT_UPLINK_RETRY_MS);
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef ANT_UPLINK_H
+#define ANT_UPLINK_H
+
+#include <Arduino.h>
+#include "ftms_data.h"
+
+#define ANT_UPLINK_PAGE_LENGTH 8
+
+struct ANTUplinkStats {
+    uint32_t frames;   // Frames written to the UART (pages and command answers)
+    uint32_t bytes;
+    uint32_t stalls;   // Writes that found the TX buffer too full and were dropped
+};
+
+// ✅ ESP32 → Raspberry Pi direction of the serial link. Pages go out in the same
+// frame layout the Pi sends us (sync | deviceType | length | payload | xor), and the
+// Pi forwards them to the ANT+ device of that type, e.g. FE-C control pages to the
+// trainer. Writes never block: a full TX buffer drops the page and counts a stall.
+class ANTUplink {
+public:
+    ANTUplink();
+    void begin(HardwareSerial &port);  // ✅ Call after the port is opened by serialIngest
+    bool sendPage(DeviceType deviceType, const uint8_t *page);
+    // ✅ 0xF0 frame to the Pi (e.g. a METRICS answer). Waits up to timeoutMs for room
+    // instead of dropping, and leaves room for one FE-C page so control never stalls
+    // behind it. Call from housekeeping code, not from the data path.
+    bool sendCommand(uint8_t type, const uint8_t *payload, uint8_t len, uint32_t timeoutMs);
+
+    const ANTUplinkStats &getStats() const { return stats; }
+
+private:
+    bool writeFrame(uint8_t sync, uint8_t type, const uint8_t *payload, uint8_t len, size_t headroom);
+
+    HardwareSerial *port;
+    ANTUplinkStats stats;
+};
+
+extern ANTUplink antUplink;
+
+#endif  // ANT_UPLINK_H
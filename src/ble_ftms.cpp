@@ -1,8 +1,30 @@
 #include "ble_ftms.h"
 #include "logger.h"
 #include "global.h"
-
-BLEFTMS::BLEFTMS() {}
+#include "metrics.h"
+#include <algorithm>
+
+BLEFTMS::BLEFTMS() : lastNotifyMs(0), minNotifyIntervalMs(1000 / FTMS_DEFAULT_NOTIFY_HZ),
+                     keepaliveMs(FTMS_DEFAULT_KEEPALIVE_MS), notifyPending(false),
+                     wheelCircumferenceMm(DEFAULT_WHEEL_CIRCUMFERENCE_MM), indoorBikeChar(nullptr),
+                     fitnessMachineFeatureChar(nullptr), fitnessMachineStatusChar(nullptr),
+                     trainingStatusChar(nullptr), controlPointChar(nullptr) {
+    memset(lastIndoorBikeData, 0, sizeof(lastIndoorBikeData));
+    notifyStats = {};
+    sensorChars = {};
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        connections[i].connHandle = BLE_CONN_HANDLE_NONE;
+        connections[i].subscriptions = 0;
+        connections[i].connectedMs = 0;
+        connections[i].notifies = 0;
+        connections[i].dropped = 0;
+        connections[i].interval = 0;
+        connections[i].mtu = 0;
+    }
+    connectedCount = 0;
+    lastCentralDepartures = 0;
+    powerIntervalDepartures = 0;
+}
 static void (*onConnectCallback)() = nullptr;
 static void (*onDisconnectCallback)() = nullptr;
 
@@ -14,11 +36,101 @@ void BLEFTMS::setDisconnectCallback(void (*callback)()) {
     onDisconnectCallback = callback;
 }
 
+BLEConnection *BLEFTMS::findConnection(uint16_t connHandle) {
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (connections[i].connHandle.load() == connHandle) return &connections[i];
+    }
+    return nullptr;
+}
+
+void BLEFTMS::addConnection(uint16_t connHandle) {
+    BLEConnection *conn = findConnection(BLE_CONN_HANDLE_NONE);
+    if (!conn) {
+        LOGF("[WARN] No free connection slot for %d", connHandle);
+        return;
+    }
+    conn->subscriptions = 0;
+    conn->connectedMs = millis();
+    conn->notifies = 0;
+    conn->dropped = 0;
+    conn->interval = 0;
+    conn->mtu = 0;
+    conn->connHandle = connHandle;  // ✅ Publish last: the notify task skips free slots
+    connectedCount++;
+}
+
+void BLEFTMS::removeConnection(uint16_t connHandle) {
+    BLEConnection *conn = findConnection(connHandle);
+    if (!conn) return;
+    LOGF("[INFO] Connection %d closed: %u notifies, %u dropped", connHandle, conn->notifies, conn->dropped);
+    conn->subscriptions = 0;
+    conn->connHandle = BLE_CONN_HANDLE_NONE;
+    if (--connectedCount == 0) lastCentralDepartures++;  // The app resets the power totals
+}
+
+void BLEFTMS::setSubscribed(Measurement measurement, uint16_t connHandle, bool subscribed) {
+    BLEConnection *conn = findConnection(connHandle);
+    if (!conn) return;  // Implicit unsubscribe after the connection is already gone
+    if (subscribed) {
+        conn->subscriptions.fetch_or(1 << measurement);
+    } else {
+        conn->subscriptions.fetch_and(~(1 << measurement));
+    }
+    LOGF("[INFO] Measurement %d %s by connection %d", measurement,
+         subscribed ? "subscribed" : "unsubscribed", connHandle);
+}
+
+uint8_t BLEFTMS::subscribedMask() const {
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (connections[i].connHandle.load() != BLE_CONN_HANDLE_NONE) mask |= connections[i].subscriptions.load();
+    }
+    return mask;
+}
+
+// ✅ One notify per subscribed connection, so a congested link only costs its own drops
+void BLEFTMS::notifySubscribers(NimBLECharacteristic *characteristic, Measurement measurement,
+                                const uint8_t *payload, size_t len) {
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        BLEConnection &conn = connections[i];
+        uint16_t handle = conn.connHandle.load();
+        if (handle == BLE_CONN_HANDLE_NONE || !(conn.subscriptions.load() & (1 << measurement))) continue;
+
+        uint32_t start = metrics.spanStart();
+        bool accepted = characteristic->notify(payload, len, handle);
+        metrics.record(METRIC_NOTIFY_LATENCY, metrics.spanUs(start));
+        if (accepted) {
+            conn.notifies++;
+            metrics.increment(METRIC_NOTIFIES_SENT);
+            metrics.markBoot(BOOT_FIRST_NOTIFY);
+        } else {
+            conn.dropped++;
+            metrics.increment(METRIC_NOTIFY_FAILURES);
+        }
+    }
+}
+
+void BLEFTMS::logConnectionStats(uint32_t nowMs) const {
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        const BLEConnection &conn = connections[i];
+        uint16_t handle = conn.connHandle.load();
+        if (handle == BLE_CONN_HANDLE_NONE) continue;
+        [[maybe_unused]] uint32_t connectedSec = (nowMs - conn.connectedMs) / 1000;  // LOGF is a no-op in release
+        LOGF("[BLE] conn %d: %u notifies (%u/s), %u dropped, subscriptions 0x%02X, interval %.2f ms, MTU %d",
+             handle, conn.notifies, connectedSec ? conn.notifies / connectedSec : conn.notifies, conn.dropped,
+             conn.subscriptions.load(), conn.interval * 1.25f, conn.mtu);
+    }
+}
+
 void BLEFTMS::begin() {
     preferences.begin("ble_ftms", false);  // Open storage
     String bleName = preferences.getString("ble_name", "ESP32-S3 FTMS");
 
     LOGF("[DEBUG] BLE Device Name: %s", bleName.c_str());
+
+    // ✅ Notify schedule set with the NOTIFY serial command
+    setNotifySchedule(preferences.getUChar("notify_hz", FTMS_DEFAULT_NOTIFY_HZ),
+                      preferences.getUShort("keepalive_ms", FTMS_DEFAULT_KEEPALIVE_MS), false);
     NimBLEDevice::init(bleName.c_str());
 
     setupFTMS();  // ✅ Setup BLE services
@@ -28,7 +140,7 @@ void BLEFTMS::begin() {
     advertisementData.setFlags(0x06);
     advertisementData.setAppearance(0x0484); // Cycling Power Sensor
 
-    std::vector<uint8_t> serviceUUIDs = { 0x05, 0x03, 0x26, 0x18, 0x18, 0x18 };
+    std::vector<uint8_t> serviceUUIDs = { 0x09, 0x03, 0x26, 0x18, 0x18, 0x18, 0x16, 0x18, 0x0D, 0x18 };
     advertisementData.addData(serviceUUIDs);
     adv->setAdvertisementData(advertisementData);
 
@@ -38,6 +150,7 @@ void BLEFTMS::begin() {
     scanResponseData.setManufacturerData(manufacturerData, sizeof(manufacturerData));
     adv->setScanResponseData(scanResponseData);
     adv->start(0);
+    metrics.markBoot(BOOT_ADVERTISING);
 
     LOG("[DEBUG] BLE Advertising Started...");
 }
@@ -46,24 +159,93 @@ void BLEFTMS::setupFTMS() {
     NimBLEServer *server = NimBLEDevice::createServer();
 
     class MyServerCallbacks : public NimBLEServerCallbacks {
+    public:
+        explicit MyServerCallbacks(BLEFTMS &ftms) : ftms(ftms) {}
+
         void onConnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo) override {
-            LOG("[INFO] BLE Device Connected!");
+            metrics.markBoot(BOOT_FIRST_CONNECT);
+            ftms.addConnection(connInfo.getConnHandle());
+            ftms.linkManager.onConnect(connInfo);
+            recordLink(connInfo);
+            LOGF("[INFO] BLE Device Connected! Handle: %d, %d connected",
+                 connInfo.getConnHandle(), ftms.getConnectedCount());
             if (onConnectCallback) onConnectCallback();
+
+            // ✅ Advertising stops on connect; keep accepting centrals while slots remain
+            if (ftms.getConnectedCount() < BLE_MAX_CONNECTIONS) NimBLEDevice::getAdvertising()->start(0);
         }
 
         void onDisconnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo, int reason) override {
-            LOGF("[INFO] BLE Device Disconnected! Reason: %d", reason);
+            LOGF("[INFO] BLE Device Disconnected! Handle: %d, Reason: %d", connInfo.getConnHandle(), reason);
+            ftms.removeConnection(connInfo.getConnHandle());
+            ftms.controlPoint.releaseControl(connInfo.getConnHandle());
             if (onDisconnectCallback) onDisconnectCallback();
             LOG("[INFO] Restarting BLE Advertising...");
             NimBLEDevice::getAdvertising()->start(0);
         }
+
+        void onConnParamsUpdate(NimBLEConnInfo &connInfo) override {
+            ftms.linkManager.onConnParamsUpdate(connInfo);
+            recordLink(connInfo);
+        }
+
+        void onMTUChange(uint16_t mtu, NimBLEConnInfo &connInfo) override {
+            ftms.linkManager.onMTUChange(mtu, connInfo);
+            BLEConnection *conn = ftms.findConnection(connInfo.getConnHandle());
+            if (conn) conn->mtu = mtu;
+        }
+
+        void onPhyUpdate(NimBLEConnInfo &connInfo, uint8_t txPhy, uint8_t rxPhy) override {
+            ftms.linkManager.onPhyUpdate(connInfo, txPhy, rxPhy);
+        }
+
+    private:
+        void recordLink(NimBLEConnInfo &connInfo) {
+            BLEConnection *conn = ftms.findConnection(connInfo.getConnHandle());
+            if (!conn) return;
+            conn->interval = connInfo.getConnInterval();
+            conn->mtu = connInfo.getMTU();
+        }
+
+        BLEFTMS &ftms;
     };
 
-    server->setCallbacks(new MyServerCallbacks());
+    // ✅ Runs on the NimBLE host task; the FE-C page goes out before this returns
+    class ControlPointCallbacks : public NimBLECharacteristicCallbacks {
+    public:
+        explicit ControlPointCallbacks(FTMSControlPoint &control) : control(control) {}
+
+        void onWrite(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo) override {
+            uint32_t receivedUs = micros();
+            const auto &value = pCharacteristic->getValue();
+            control.handleWrite(value.data(), value.size(), receivedUs, connInfo.getConnHandle());
+        }
+
+    private:
+        FTMSControlPoint &control;
+    };
+
+    // ✅ CCCD writes (and the implicit unsubscribe on disconnect) for one measurement
+    class SubscriptionCallbacks : public NimBLECharacteristicCallbacks {
+    public:
+        SubscriptionCallbacks(BLEFTMS &ftms, Measurement measurement) : ftms(ftms), measurement(measurement) {}
+
+        void onSubscribe(NimBLECharacteristic *pCharacteristic, NimBLEConnInfo &connInfo, uint16_t subValue) override {
+            ftms.setSubscribed(measurement, connInfo.getConnHandle(), subValue != 0);
+        }
+
+    private:
+        BLEFTMS &ftms;
+        Measurement measurement;
+    };
+
+    server->setCallbacks(new MyServerCallbacks(*this));
+    linkManager.begin(server);
     NimBLEService *ftmsService = server->createService(NimBLEUUID((uint16_t) 0x1826)); // FTMS Service UUID
 
     indoorBikeChar = ftmsService->createCharacteristic(
         NimBLEUUID((uint16_t) 0x2AD2), NIMBLE_PROPERTY::NOTIFY);
+    indoorBikeChar->setCallbacks(new SubscriptionCallbacks(*this, MEASUREMENT_INDOOR_BIKE));
 
     fitnessMachineFeatureChar = ftmsService->createCharacteristic(
         NimBLEUUID((uint16_t) 0x2ACC), NIMBLE_PROPERTY::READ);
@@ -76,12 +258,33 @@ void BLEFTMS::setupFTMS() {
     trainingStatusChar = ftmsService->createCharacteristic(
         NimBLEUUID((uint16_t) 0x2AD3), NIMBLE_PROPERTY::NOTIFY);
 
+    // ✅ Ranges the apps read before sending targets (min, max, increment; little-endian)
+    NimBLECharacteristic *powerRangeChar = ftmsService->createCharacteristic(
+        NimBLEUUID((uint16_t) 0x2AD8), NIMBLE_PROPERTY::READ);
+    uint8_t powerRange[6] = { 0, 0, FTMS_MAX_TARGET_POWER & 0xFF, FTMS_MAX_TARGET_POWER >> 8, 1, 0 };
+    powerRangeChar->setValue(powerRange, sizeof(powerRange));
+
+    NimBLECharacteristic *resistanceRangeChar = ftmsService->createCharacteristic(
+        NimBLEUUID((uint16_t) 0x2AD6), NIMBLE_PROPERTY::READ);
+    uint8_t resistanceRange[6] = { 0, 0, FTMS_MAX_RESISTANCE_LEVEL & 0xFF, FTMS_MAX_RESISTANCE_LEVEL >> 8, 10, 0 };
+    resistanceRangeChar->setValue(resistanceRange, sizeof(resistanceRange));
+
+    controlPointChar = ftmsService->createCharacteristic(
+        NimBLEUUID((uint16_t) 0x2AD9), NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::INDICATE);
+    controlPointChar->setCallbacks(new ControlPointCallbacks(controlPoint));
+    controlPoint.attach(controlPointChar, fitnessMachineStatusChar);
+
     ftmsService->start();
+
+    sensorChars = setupSensorServices(server);
+    sensorChars.cyclingPower->setCallbacks(new SubscriptionCallbacks(*this, MEASUREMENT_CYCLING_POWER));
+    sensorChars.csc->setCallbacks(new SubscriptionCallbacks(*this, MEASUREMENT_CSC));
+    sensorChars.heartRate->setCallbacks(new SubscriptionCallbacks(*this, MEASUREMENT_HEART_RATE));
 }
 
 void BLEFTMS::setupFTMSFeatures() {
-    uint32_t features = 0x00005086; // Speed, Cadence, Power, Resistance Level
-    uint32_t targetSettings = 0x00000000; // No target settings
+    uint32_t features = 0x00005286; // Cadence, Distance, Resistance Level, Expended Energy, Elapsed Time, Power
+    uint32_t targetSettings = 0x0000200C; // Resistance, Power, Indoor Bike Simulation targets
 
     // Convert to little-endian byte array (BLE requires LSB first)
     uint8_t featureData[8];
@@ -102,11 +305,11 @@ void BLEFTMS::setupFTMSFeatures() {
 // 🔹 Prepare FTMS Indoor Bike Data for BLE notification
 void BLEFTMS::prepareFTMSData(uint8_t* data, const FTMSDataStorage& ftmsData) {
     // ✅ Ensure buffer is initialized to prevent memory corruption
-    memset(data, 0, 15);
+    memset(data, 0, FTMS_INDOOR_BIKE_DATA_LEN);
 
     // ✅ 1. Correct Flag Bytes (Bit 0 = 0, Instantaneous Speed is still included)
     data[0] = 0x74;  // Flag Byte 0
-    data[1] = 0x08;  // Flag Byte 1
+    data[1] = 0x09;  // Flag Byte 1: Expended Energy, Elapsed Time
 
     // ✅ 2. Instantaneous Speed (0.01 km/h resolution, Little-Endian)
     uint16_t speed_kmh = static_cast<uint16_t>(ftmsData.speed * 100);
@@ -139,41 +342,155 @@ void BLEFTMS::prepareFTMSData(uint8_t* data, const FTMSDataStorage& ftmsData) {
     data[12] = (power >> 8) & 0xFF;
     LOGF("[DEBUG] Instantaneous Power: %d W -> Encoded: 0x%02X%02X", power, data[11], data[12]);
 
-    // ✅ 7. Elapsed Time (2-byte uint16, Little-Endian)
-    uint16_t elapsedTime = static_cast<uint16_t>(ftmsData.elapsed_time);
-    data[13] = elapsedTime & 0xFF;
-    data[14] = (elapsedTime >> 8) & 0xFF;
+    // ✅ 7. Expended Energy: Total (kcal, uint16), Per Hour (kcal, uint16), Per Minute (kcal, uint8)
+    float kcalPerHour = ftmsData.instantaneous_power * 3.6f * KCAL_PER_KJ;
+    uint16_t totalEnergy = static_cast<uint16_t>(std::min(ftmsData.energy_joules / 1000.0f * KCAL_PER_KJ + 0.5f, 65534.0f));
+    uint16_t energyPerHour = static_cast<uint16_t>(std::min(kcalPerHour + 0.5f, 65534.0f));  // 0xFFFF: not available
+    uint8_t energyPerMinute = static_cast<uint8_t>(std::min(kcalPerHour / 60.0f + 0.5f, 254.0f));
+    data[13] = totalEnergy & 0xFF;
+    data[14] = (totalEnergy >> 8) & 0xFF;
+    data[15] = energyPerHour & 0xFF;
+    data[16] = (energyPerHour >> 8) & 0xFF;
+    data[17] = energyPerMinute;
+    LOGF("[DEBUG] Expended Energy: %d kcal, %d kcal/h, %d kcal/min", totalEnergy, energyPerHour, energyPerMinute);
+
+    // ✅ 8. Elapsed Time (2-byte uint16, Little-Endian)
+    uint16_t elapsedTime = static_cast<uint16_t>(std::min(ftmsData.elapsed_time, (uint32_t)0xFFFF));
+    data[18] = elapsedTime & 0xFF;
+    data[19] = (elapsedTime >> 8) & 0xFF;
     LOGF("[DEBUG] Elapsed Time: %d sec (2-byte encoding)", elapsedTime);
 
-    // ✅ Debug final buffer output
-    LOGF("[DEBUG] BLE FTMS Data (15 bytes): %02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X",
-         data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7], data[8], 
-         data[9], data[10], data[11], data[12], data[13], data[14]);
+    // ✅ Debug final buffer output, in two lines (LOG_MAX_ARGS)
+    LOGF("[DEBUG] BLE FTMS Data (20 bytes): %02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-",
+         data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7], data[8], data[9]);
+    LOGF("[DEBUG]   %02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X",
+         data[10], data[11], data[12], data[13], data[14], data[15], data[16], data[17], data[18], data[19]);
 }
 
 
 // 🔹 Send FTMS BLE Notification
 void BLEFTMS::sendIndoorBikeData(const FTMSDataStorage& ftmsData) {
-    uint8_t data[15] = {0};  
+    uint8_t data[FTMS_INDOOR_BIKE_DATA_LEN] = {0};
 
     LOGF("[DEBUG] SSending BLE FTMS: Power=%dW, Speed=%.1f km/h, Cadence=%d rpm, Distance=%u m, Resistance=%.1f, Elapsed Time=%u s",
         ftmsData.power, ftmsData.speed, ftmsData.cadence, static_cast<unsigned int>(ftmsData.distance), ftmsData.resistance, static_cast<unsigned int>(ftmsData.elapsed_time));
     
     prepareFTMSData(data, ftmsData);
+    notifyIndoorBikeData(data);
 
-    /*
-    LOGF("[DEBUG] BLE FTMS Data (15 bytes): %02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X-%02X",
-        data[0], data[1], data[2], data[3], data[4], data[5], data[6], data[7],
-        data[8], data[9], data[10], data[11], data[12], data[13], data[14]);
-    */  
-    if (indoorBikeChar) {
-        indoorBikeChar->notify((const uint8_t*)data, sizeof(data));
-    } else {
+    //updateFitnessMachineStatus(ftmsData);
+    //updateTrainingStatus(ftmsData);
+}
+
+bool BLEFTMS::notifyIndoorBikeData(const uint8_t *payload) {
+    if (!indoorBikeChar) {
         LOG("[ERROR] BLE Indoor Bike Characteristic is NULL!");
+        return false;
     }
+    indoorBikeChar->notify(payload, FTMS_INDOOR_BIKE_DATA_LEN);
+    return true;
+}
 
-    //updateFitnessMachineStatus(ftmsData);
-    //updateTrainingStatus(ftmsData);
+NotifyResult BLEFTMS::updateMeasurements(const FTMSDataStorage& ftmsData, bool fresh, uint32_t nowMs) {
+    if (fresh) notifyPending = true;
+
+    // ✅ Power totals restart once the last central leaves: never average across the
+    // old and the new accumulation, even when the new totals have passed the old ones
+    uint32_t departures = lastCentralDepartures.load();
+    if (departures != powerIntervalDepartures || ftmsData.power_event_total < powerInterval.lastEvents) {
+        powerIntervalDepartures = departures;
+        powerInterval.reset();
+    }
+
+    uint32_t sinceLast = nowMs - lastNotifyMs;
+    bool keepaliveDue = sinceLast >= keepaliveMs;
+
+    if (!notifyPending && !keepaliveDue) return NotifyResult::NotDue;
+    if (!keepaliveDue && sinceLast < minNotifyIntervalMs) {
+        notifyStats.rateLimited++;
+        return NotifyResult::RateLimited;  // Caller retries after getNotifyWaitMs()
+    }
+
+    // ✅ Revolution counters follow the fused rates whether or not anyone listens
+    wheelSynth.advance(wheelRpm(ftmsData.speed, wheelCircumferenceMm), nowMs);
+    crankSynth.advance(ftmsData.cadence, nowMs);
+
+    uint8_t subscribed = subscribedMask();
+    if (!subscribed) {
+        notifyPending = false;
+        lastNotifyMs = nowMs;  // Next look at the keepalive, not in a tight loop
+        return NotifyResult::NotDue;
+    }
+
+    // ✅ Report the true average power since the last notify, not the latest snapshot
+    FTMSDataStorage notified = ftmsData;
+    uint16_t averagePower;
+    if (powerInterval.average(ftmsData, averagePower)) {
+        notified.instantaneous_power = averagePower;
+    }
+
+    // Indoor Bike Data is always encoded: it is also the change detector for the tick
+    uint8_t data[FTMS_INDOOR_BIKE_DATA_LEN];
+    prepareFTMSData(data, notified);
+    notifyPending = false;
+
+    // ✅ Skip identical payloads; the keepalive still goes out so clients see we're alive
+    if (!keepaliveDue && memcmp(data, lastIndoorBikeData, sizeof(data)) == 0) {
+        notifyStats.unchanged++;
+        return NotifyResult::Unchanged;
+    }
+
+    if (subscribed & (1 << MEASUREMENT_INDOOR_BIKE)) {
+        notifySubscribers(indoorBikeChar, MEASUREMENT_INDOOR_BIKE, data, sizeof(data));
+    }
+    memcpy(lastIndoorBikeData, data, sizeof(data));
+
+    uint8_t payload[CPS_MEASUREMENT_MAX_LEN];
+    if (subscribed & (1 << MEASUREMENT_CYCLING_POWER)) {
+        size_t len = encodeCyclingPowerMeasurement(payload, notified, wheelSynth, crankSynth);
+        notifySubscribers(sensorChars.cyclingPower, MEASUREMENT_CYCLING_POWER, payload, len);
+    }
+    if (subscribed & (1 << MEASUREMENT_CSC)) {
+        size_t len = encodeCSCMeasurement(payload, wheelSynth, crankSynth);
+        notifySubscribers(sensorChars.csc, MEASUREMENT_CSC, payload, len);
+    }
+    if (subscribed & (1 << MEASUREMENT_HEART_RATE)) {
+        size_t len = encodeHeartRateMeasurement(payload, notified);
+        notifySubscribers(sensorChars.heartRate, MEASUREMENT_HEART_RATE, payload, len);
+    }
+
+    powerInterval.commit(ftmsData);
+    lastNotifyMs = nowMs;
+    notifyStats.sent++;
+    if (keepaliveDue && !fresh) notifyStats.keepalives++;
+    return NotifyResult::Sent;
+}
+
+uint32_t BLEFTMS::getNotifyWaitMs(uint32_t nowMs) const {
+    uint32_t sinceLast = nowMs - lastNotifyMs;
+    uint32_t due = notifyPending ? minNotifyIntervalMs : keepaliveMs;
+    return sinceLast >= due ? 0 : due - sinceLast;
+}
+
+bool BLEFTMS::setNotifySchedule(uint8_t maxRateHz, uint16_t keepalive, bool persist) {
+    if (maxRateHz < 1 || maxRateHz > 50 || keepalive < 250 || keepalive > 10000 ||
+        keepalive < 1000 / maxRateHz) {
+        LOGF("[ERROR] Invalid notify schedule: %d Hz, keepalive %d ms", maxRateHz, keepalive);
+        return false;
+    }
+
+    minNotifyIntervalMs = 1000 / maxRateHz;
+    keepaliveMs = keepalive;
+
+    if (persist) {
+        preferences.begin("ble_ftms", false);
+        preferences.putUChar("notify_hz", maxRateHz);
+        preferences.putUShort("keepalive_ms", keepalive);
+        preferences.end();
+    }
+
+    LOGF("[INFO] Indoor Bike Data notify: max %d Hz, keepalive %d ms", maxRateHz, keepalive);
+    return true;
 }
 
 uint8_t BLEFTMS::determineTrainingStatus(const FTMSDataStorage& ftmsData) {
@@ -298,7 +615,7 @@ String BLEFTMS::getDeviceMAC() {
     return NimBLEDevice::getAddress().toString().c_str();
 }
 
+// ✅ Targets are forwarded to the trainer as FE-C pages once the Control Point exists
 bool BLEFTMS::deviceSupportsControl() {
-    // Implement the logic to determine if the device supports control
-    return false; // Placeholder implementation
+    return controlPoint.isAttached();
 }
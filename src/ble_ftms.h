@@ -4,12 +4,72 @@
 #include <Arduino.h>
 #include <NimBLEDevice.h>
 #include "ant_parser.h"
+#include "power_accumulator.h"
+#include "ftms_control_point.h"
+#include "ble_sensor_services.h"
+#include "ble_link_manager.h"
+#include <atomic>
+
+#define FTMS_INDOOR_BIKE_DATA_LEN 20
+#define FTMS_DEFAULT_NOTIFY_HZ 4
+#define FTMS_DEFAULT_KEEPALIVE_MS 2000
+
+// ✅ Centrals served at once (e.g. a phone app plus a head unit). NimBLE's own limit
+// is CONFIG_BT_NIMBLE_MAX_CONNECTIONS; raise both together.
+#ifndef BLE_MAX_CONNECTIONS
+    #ifdef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+        #define BLE_MAX_CONNECTIONS CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+    #else
+        #define BLE_MAX_CONNECTIONS 3
+    #endif
+#endif
+#define BLE_CONN_HANDLE_NONE 0xFFFF
+
+// ✅ Outcome of one pass of the Indoor Bike Data notify scheduler
+enum class NotifyResult : uint8_t {
+    Sent,         // Notified (fresh data, or keepalive)
+    RateLimited,  // Fresh data, but the max rate window is still closed
+    Unchanged,    // Fresh data encoded to the same payload as the last notify
+    NotDue        // Nothing fresh and keepalive not due yet
+};
+
+struct NotifySchedulerStats {
+    uint32_t sent;
+    uint32_t keepalives;
+    uint32_t rateLimited;
+    uint32_t unchanged;
+};
+
+// ✅ One connected central. The handle and subscriptions are written by the NimBLE
+// host task (connect, disconnect, CCCD writes); the counters only by the notify task.
+struct BLEConnection {
+    std::atomic<uint16_t> connHandle;    // BLE_CONN_HANDLE_NONE when the slot is free
+    std::atomic<uint8_t> subscriptions;  // Bit per Measurement with notify enabled
+    uint32_t connectedMs;
+    uint32_t notifies;  // Notifies the stack accepted for this connection
+    uint32_t dropped;   // Notifies it refused (out of buffers, link congested)
+    uint16_t interval;  // Negotiated connection interval, 1.25 ms units
+    uint16_t mtu;
+};
 
 class BLEFTMS {
 public:
     BLEFTMS();
     void begin();
     void sendIndoorBikeData(const FTMSDataStorage &ftmsData);
+
+    // ✅ Notify-on-change scheduler: call with fresh=true when the parser has new data
+    // and whenever getNotifyWaitMs() elapses. Notifies at most maxRateHz, skips payloads
+    // identical to the last one, and sends a keepalive every keepaliveMs regardless.
+    // Each tick encodes Indoor Bike Data, Cycling Power, CSC and Heart Rate from the
+    // same snapshot, skipping the ones nobody is subscribed to.
+    NotifyResult updateMeasurements(const FTMSDataStorage &ftmsData, bool fresh, uint32_t nowMs);
+    uint32_t getNotifyWaitMs(uint32_t nowMs) const;
+    uint16_t getNotifyIntervalMs() const { return minNotifyIntervalMs; }
+    bool setNotifySchedule(uint8_t maxRateHz, uint16_t keepaliveMs, bool persist = true);
+    const NotifySchedulerStats &getNotifyStats() const { return notifyStats; }
+    // ✅ Wheel behind the CPS/CSC wheel revolutions; from the notify task, before updateMeasurements()
+    void setWheelCircumference(uint16_t millimeters) { wheelCircumferenceMm = millimeters; }
     uint8_t determineTrainingStatus(const FTMSDataStorage &ftmsData);
     uint8_t determineEventID(const FTMSDataStorage &ftmsData);
     void sendFitnessMachineStatus(const FTMSDataStorage &ftmsData);
@@ -19,18 +79,51 @@ public:
     void updateFitnessMachineStatus(const FTMSDataStorage &ftmsData);
     String getDeviceMAC();
     bool deviceSupportsControl();
+    FTMSControlPoint &getControlPoint() { return controlPoint; }
+    BLELinkManager &getLinkManager() { return linkManager; }
     void setConnectCallback(void (*callback)());
     void setDisconnectCallback(void (*callback)());
+    void setSubscribed(Measurement measurement, uint16_t connHandle, bool subscribed);  // ✅ From CCCD writes
+    bool isSubscribed(Measurement measurement) const { return (subscribedMask() >> measurement) & 1; }
+    uint8_t getConnectedCount() const { return connectedCount.load(); }
+    const BLEConnection &getConnection(uint8_t slot) const { return connections[slot]; }
+    void logConnectionStats(uint32_t nowMs) const;
 
 private:
     void setupFTMS();  // ✅ Ensure it's declared in the class
 
     void setupFTMSFeatures();
+    bool notifyIndoorBikeData(const uint8_t *payload);
+    void notifySubscribers(NimBLECharacteristic *characteristic, Measurement measurement,
+                           const uint8_t *payload, size_t len);
+    uint8_t subscribedMask() const;  // ✅ Union over connections, bit per Measurement
+    BLEConnection *findConnection(uint16_t connHandle);
+    void addConnection(uint16_t connHandle);
+    void removeConnection(uint16_t connHandle);
+
+    uint8_t lastIndoorBikeData[FTMS_INDOOR_BIKE_DATA_LEN];
+    uint32_t lastNotifyMs;
+    uint16_t minNotifyIntervalMs;
+    uint16_t keepaliveMs;
+    bool notifyPending;
+    NotifySchedulerStats notifyStats;
+    PowerInterval powerInterval;  // ✅ Average power between two Indoor Bike Data notifies
+    uint32_t powerIntervalDepartures;  // lastCentralDepartures when powerInterval was last reset
+    FTMSControlPoint controlPoint;  // ✅ ERG/simulation targets → FE-C pages to the trainer
+    BLELinkManager linkManager;  // ✅ Connection interval, PHY, DLE and MTU per link
+    SensorMeasurementChars sensorChars;  // ✅ CPS, CSC and HR measurements
+    RevolutionSynth wheelSynth;  // ✅ Wheel/crank revolution data for CPS and CSC
+    RevolutionSynth crankSynth;
+    uint16_t wheelCircumferenceMm;
+    BLEConnection connections[BLE_MAX_CONNECTIONS];
+    std::atomic<uint8_t> connectedCount;
+    std::atomic<uint32_t> lastCentralDepartures;  // ✅ Set from the NimBLE host task, read by the notify task
 
     NimBLECharacteristic *indoorBikeChar;
     NimBLECharacteristic *fitnessMachineFeatureChar;  // ✅ New characteristic
     NimBLECharacteristic *fitnessMachineStatusChar;  // ✅ New characteristic
     NimBLECharacteristic *trainingStatusChar;  // ✅ New characteristic
+    NimBLECharacteristic *controlPointChar;
 };
 
 #endif  // BLE_FTMS_H
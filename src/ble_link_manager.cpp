@@ -0,0 +1,83 @@
+#include "ble_link_manager.h"
+#include "logger.h"
+#include "global.h"
+
+static const LinkParams LOW_LATENCY_PARAMS = { 6, 12, 0, 200 };   // 7.5-15 ms, 2 s supervision
+static const LinkParams LOW_POWER_PARAMS = { 24, 40, 4, 600 };    // 30-50 ms, 6 s supervision
+
+BLELinkManager::BLELinkManager() : server(nullptr), profile(LinkProfile::LowLatency) {}
+
+const char *BLELinkManager::profileName(LinkProfile profile) {
+    return profile == LinkProfile::LowPower ? "low-power" : "low-latency";
+}
+
+const LinkParams &BLELinkManager::paramsFor(LinkProfile profile) {
+    return profile == LinkProfile::LowPower ? LOW_POWER_PARAMS : LOW_LATENCY_PARAMS;
+}
+
+void BLELinkManager::begin(NimBLEServer *bleServer) {
+    server = bleServer;
+
+    preferences.begin("ble_ftms", true);
+    uint8_t stored = preferences.getUChar("link_profile", (uint8_t)LinkProfile::LowLatency);
+    preferences.end();
+    profile = stored == (uint8_t)LinkProfile::LowPower ? LinkProfile::LowPower : LinkProfile::LowLatency;
+
+    NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
+#if BLE_LINK_2M_PHY
+    NimBLEDevice::setDefaultPhy(BLE_GAP_LE_PHY_2M_MASK | BLE_GAP_LE_PHY_1M_MASK,
+                                BLE_GAP_LE_PHY_2M_MASK | BLE_GAP_LE_PHY_1M_MASK);
+#endif
+    LOGF("[INFO] BLE link profile: %s, MTU %d, 2M PHY %s", profileName(profile), BLE_PREFERRED_MTU,
+         BLE_LINK_2M_PHY ? "preferred" : "not supported");
+}
+
+void BLELinkManager::requestParams(uint16_t connHandle) {
+    const LinkParams &p = paramsFor(profile);
+    server->updateConnParams(connHandle, p.minInterval, p.maxInterval, p.latency, p.timeout);
+}
+
+void BLELinkManager::onConnect(NimBLEConnInfo &connInfo) {
+    if (!server) return;
+    uint16_t handle = connInfo.getConnHandle();
+
+    LOGF("[BLE] conn %d opened: interval %.2f ms, latency %d, timeout %d ms", handle,
+         connInfo.getConnInterval() * 1.25f, connInfo.getConnLatency(), connInfo.getConnTimeout() * 10);
+
+    requestParams(handle);
+    server->setDataLen(handle, BLE_PREFERRED_TX_OCTETS);
+#if BLE_LINK_2M_PHY
+    server->updatePhy(handle, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, 0);
+#endif
+}
+
+void BLELinkManager::onConnParamsUpdate(NimBLEConnInfo &connInfo) {
+    LOGF("[BLE] conn %d params: interval %.2f ms, latency %d, timeout %d ms", connInfo.getConnHandle(),
+         connInfo.getConnInterval() * 1.25f, connInfo.getConnLatency(), connInfo.getConnTimeout() * 10);
+}
+
+void BLELinkManager::onMTUChange(uint16_t mtu, NimBLEConnInfo &connInfo) {
+    LOGF("[BLE] conn %d MTU: %d", connInfo.getConnHandle(), mtu);
+}
+
+void BLELinkManager::onPhyUpdate(NimBLEConnInfo &connInfo, uint8_t txPhy, uint8_t rxPhy) {
+    LOGF("[BLE] conn %d PHY: tx %s, rx %s", connInfo.getConnHandle(),
+         txPhy == BLE_GAP_LE_PHY_2M ? "2M" : "1M", rxPhy == BLE_GAP_LE_PHY_2M ? "2M" : "1M");
+}
+
+bool BLELinkManager::setProfile(LinkProfile newProfile, bool persist) {
+    profile = newProfile;
+
+    if (persist) {
+        preferences.begin("ble_ftms", false);
+        preferences.putUChar("link_profile", (uint8_t)newProfile);
+        preferences.end();
+    }
+
+    // ✅ Apply to links that are already up, not just the next connection
+    if (server) {
+        for (uint16_t handle : server->getPeerDevices()) requestParams(handle);
+    }
+    LOGF("[INFO] BLE link profile: %s", profileName(newProfile));
+    return true;
+}
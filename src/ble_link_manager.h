@@ -0,0 +1,56 @@
+#ifndef BLE_LINK_MANAGER_H
+#define BLE_LINK_MANAGER_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+
+#define BLE_PREFERRED_MTU 247       // Largest ATT MTU that fits one 251-byte LL packet
+#define BLE_PREFERRED_TX_OCTETS 251  // Data length extension
+
+// ✅ 2M PHY needs a Bluetooth 5 controller (ESP32-S3/C3); the original ESP32 is 1M only
+#if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3) || defined(NATIVE_BUILD)
+    #define BLE_LINK_2M_PHY 1
+#else
+    #define BLE_LINK_2M_PHY 0
+#endif
+
+enum class LinkProfile : uint8_t {
+    LowLatency,  // 7.5-15 ms interval, no slave latency: crisp ERG and live data
+    LowPower     // 30-50 ms interval, slave latency 4: less radio time per notify
+};
+
+// Requested connection parameters, in BLE units (interval 1.25 ms, timeout 10 ms)
+struct LinkParams {
+    uint16_t minInterval;
+    uint16_t maxInterval;
+    uint16_t latency;
+    uint16_t timeout;
+};
+
+// ✅ Tunes every link as it comes up: asks the central for the profile's connection
+// parameters, prefers 2M PHY where the chip has it, enables DLE, and advertises a
+// large MTU. The central has the last word, so whatever it settles on is logged from
+// the update callbacks. The profile is switched at runtime with LINK LOWLATENCY /
+// LINK LOWPOWER and re-applied to every open connection.
+class BLELinkManager {
+public:
+    BLELinkManager();
+    void begin(NimBLEServer *server);  // ✅ Loads the profile; call before advertising
+    void onConnect(NimBLEConnInfo &connInfo);
+    void onConnParamsUpdate(NimBLEConnInfo &connInfo);
+    void onMTUChange(uint16_t mtu, NimBLEConnInfo &connInfo);
+    void onPhyUpdate(NimBLEConnInfo &connInfo, uint8_t txPhy, uint8_t rxPhy);
+
+    bool setProfile(LinkProfile profile, bool persist = true);
+    LinkProfile getProfile() const { return profile; }
+    static const char *profileName(LinkProfile profile);
+    static const LinkParams &paramsFor(LinkProfile profile);
+
+private:
+    void requestParams(uint16_t connHandle);
+
+    NimBLEServer *server;
+    LinkProfile profile;
+};
+
+#endif  // BLE_LINK_MANAGER_H
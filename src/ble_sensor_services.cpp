@@ -0,0 +1,79 @@
+#include "ble_sensor_services.h"
+#include "logger.h"
+
+#define CPS_FLAG_WHEEL_REVOLUTIONS 0x0010
+#define CPS_FLAG_CRANK_REVOLUTIONS 0x0020
+#define CPS_FEATURE_WHEEL_AND_CRANK 0x0000000C
+#define CSC_FLAG_WHEEL_REVOLUTIONS 0x01
+#define CSC_FLAG_CRANK_REVOLUTIONS 0x02
+#define SENSOR_LOCATION_REAR_HUB 0x0D
+
+static inline uint8_t *putUint16(uint8_t *p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static inline uint8_t *putUint32(uint8_t *p, uint32_t value) {
+    p = putUint16(p, value & 0xFFFF);
+    return putUint16(p, value >> 16);
+}
+
+SensorMeasurementChars setupSensorServices(NimBLEServer *server) {
+    SensorMeasurementChars chars;
+
+    NimBLEService *cps = server->createService(NimBLEUUID((uint16_t) 0x1818));  // Cycling Power
+    chars.cyclingPower = cps->createCharacteristic(NimBLEUUID((uint16_t) 0x2A63), NIMBLE_PROPERTY::NOTIFY);
+    uint32_t cpsFeatures = CPS_FEATURE_WHEEL_AND_CRANK;
+    uint8_t cpsFeatureData[4];
+    putUint32(cpsFeatureData, cpsFeatures);
+    cps->createCharacteristic(NimBLEUUID((uint16_t) 0x2A65), NIMBLE_PROPERTY::READ)
+        ->setValue(cpsFeatureData, sizeof(cpsFeatureData));
+    uint8_t location = SENSOR_LOCATION_REAR_HUB;
+    cps->createCharacteristic(NimBLEUUID((uint16_t) 0x2A5D), NIMBLE_PROPERTY::READ)->setValue(&location, 1);
+    cps->start();
+
+    NimBLEService *csc = server->createService(NimBLEUUID((uint16_t) 0x1816));  // Cycling Speed and Cadence
+    chars.csc = csc->createCharacteristic(NimBLEUUID((uint16_t) 0x2A5B), NIMBLE_PROPERTY::NOTIFY);
+    uint8_t cscFeatures[2] = { CSC_FLAG_WHEEL_REVOLUTIONS | CSC_FLAG_CRANK_REVOLUTIONS, 0x00 };
+    csc->createCharacteristic(NimBLEUUID((uint16_t) 0x2A5C), NIMBLE_PROPERTY::READ)
+        ->setValue(cscFeatures, sizeof(cscFeatures));
+    csc->createCharacteristic(NimBLEUUID((uint16_t) 0x2A5D), NIMBLE_PROPERTY::READ)->setValue(&location, 1);
+    csc->start();
+
+    NimBLEService *hrs = server->createService(NimBLEUUID((uint16_t) 0x180D));  // Heart Rate
+    chars.heartRate = hrs->createCharacteristic(NimBLEUUID((uint16_t) 0x2A37), NIMBLE_PROPERTY::NOTIFY);
+    hrs->start();
+
+    LOG("[DEBUG] Cycling Power, CSC and Heart Rate services created");
+    return chars;
+}
+
+// ✅ Flags, instantaneous power, wheel revolutions (1/2048 s), crank revolutions (1/1024 s)
+size_t encodeCyclingPowerMeasurement(uint8_t *out, const FTMSDataStorage &data,
+                                     const RevolutionSynth &wheel, const RevolutionSynth &crank) {
+    uint8_t *p = putUint16(out, CPS_FLAG_WHEEL_REVOLUTIONS | CPS_FLAG_CRANK_REVOLUTIONS);
+    p = putUint16(p, (uint16_t)(int16_t)data.instantaneous_power);
+    p = putUint32(p, wheel.revolutions);
+    p = putUint16(p, wheel.eventTime(2048));
+    p = putUint16(p, (uint16_t)crank.revolutions);
+    p = putUint16(p, crank.eventTime(1024));
+    return p - out;
+}
+
+// ✅ Flags, wheel revolutions + event time, crank revolutions + event time (1/1024 s)
+size_t encodeCSCMeasurement(uint8_t *out, const RevolutionSynth &wheel, const RevolutionSynth &crank) {
+    out[0] = CSC_FLAG_WHEEL_REVOLUTIONS | CSC_FLAG_CRANK_REVOLUTIONS;
+    uint8_t *p = putUint32(out + 1, wheel.revolutions);
+    p = putUint16(p, wheel.eventTime(1024));
+    p = putUint16(p, (uint16_t)crank.revolutions);
+    p = putUint16(p, crank.eventTime(1024));
+    return p - out;
+}
+
+// ✅ Flags 0x00: 8-bit heart rate, no contact/energy/RR fields
+size_t encodeHeartRateMeasurement(uint8_t *out, const FTMSDataStorage &data) {
+    out[0] = 0x00;
+    out[1] = data.heart_rate;
+    return HR_MEASUREMENT_LEN;
+}
@@ -0,0 +1,40 @@
+#ifndef BLE_SENSOR_SERVICES_H
+#define BLE_SENSOR_SERVICES_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include "ftms_data.h"
+#include "speed_cadence.h"
+
+#define CPS_MEASUREMENT_MAX_LEN 14
+#define CSC_MEASUREMENT_LEN 11
+#define HR_MEASUREMENT_LEN 2
+
+// ✅ Measurement characteristics served next to FTMS Indoor Bike Data. Each one is
+// encoded only while some client has its CCCD subscribed.
+enum Measurement : uint8_t {
+    MEASUREMENT_INDOOR_BIKE,    // FTMS 0x2AD2
+    MEASUREMENT_CYCLING_POWER,  // CPS 0x2A63
+    MEASUREMENT_CSC,            // CSC 0x2A5B
+    MEASUREMENT_HEART_RATE,     // HRS 0x2A37
+    MEASUREMENT_COUNT
+};
+
+struct SensorMeasurementChars {
+    NimBLECharacteristic *cyclingPower;
+    NimBLECharacteristic *csc;
+    NimBLECharacteristic *heartRate;
+};
+
+// Creates the Cycling Power (0x1818), Cycling Speed and Cadence (0x1816) and Heart
+// Rate (0x180D) services with their feature/location characteristics
+SensorMeasurementChars setupSensorServices(NimBLEServer *server);
+
+// Encoders return the payload length. Revolution data comes from RevolutionSynth,
+// since the fused snapshot only carries rates.
+size_t encodeCyclingPowerMeasurement(uint8_t *out, const FTMSDataStorage &data,
+                                     const RevolutionSynth &wheel, const RevolutionSynth &crank);
+size_t encodeCSCMeasurement(uint8_t *out, const RevolutionSynth &wheel, const RevolutionSynth &crank);
+size_t encodeHeartRateMeasurement(uint8_t *out, const FTMSDataStorage &data);
+
+#endif  // BLE_SENSOR_SERVICES_H
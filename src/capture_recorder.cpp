@@ -0,0 +1,221 @@
+#include "capture_recorder.h"
+#include <LittleFS.h>
+#include <atomic>
+#include "global.h"
+#include "logger.h"
+#include "storage.h"
+
+struct CaptureItem {
+    uint32_t arrivalUs;
+    CaptureSource source;
+    uint8_t length;
+    uint8_t frame[CAPTURE_FRAME_MAX_BYTES];
+};
+
+static QueueHandle_t captureQueue = nullptr;
+static std::atomic<bool> enabled(false);
+static std::atomic<bool> mounted(false);
+static CaptureStats stats;
+
+// ✅ Only the recorder task touches these
+static CaptureBlockWriter writer;
+static uint8_t blockBuffer[CAPTURE_FILE_HEADER_BYTES + CAPTURE_BLOCK_MAX_BYTES];
+static File segment;
+static uint32_t segmentSeq = 0;  // Newest segment on flash
+static uint32_t segmentStartMs = 0;
+static bool segmentActive = false;  // Records since the last rotation (the file opens on the first block)
+static uint32_t blockStartMs = 0;
+static uint32_t lastArrivalUs = 0;
+static uint64_t arrivalHighUs = 0;  // micros() wraps every ~71 minutes
+
+// ✅ Deletes every segment that has dropped out of the ring; returns the newest sequence
+static uint32_t pruneSegments(uint32_t keepFrom) {
+    return storage_prune(CAPTURE_DIR, CAPTURE_EXTENSION, keepFrom);
+}
+
+static bool mountFilesystem() {
+    if (!storage_mount()) {
+        LOG("[ERROR] Capture: no filesystem, recorder off");
+        return false;
+    }
+    if (!LittleFS.exists(CAPTURE_DIR)) LittleFS.mkdir(CAPTURE_DIR);
+
+    // ✅ Continue the ring after the segments of previous boots
+    segmentSeq = pruneSegments(0);
+    if (segmentSeq >= CAPTURE_SEGMENTS) pruneSegments(segmentSeq - CAPTURE_SEGMENTS + 2);
+    LOGF("[INFO] Capture: next segment %u", segmentSeq + 1);
+    return true;
+}
+
+// ✅ Header (new segment) and block go out in one write
+static void writeBlock() {
+    size_t offset = 0;
+    if (!segment) {
+        char path[32];
+        segmentSeq++;
+        if (segmentSeq >= CAPTURE_SEGMENTS) pruneSegments(segmentSeq - CAPTURE_SEGMENTS + 1);
+        storage_numbered_path(path, sizeof(path), CAPTURE_DIR, CAPTURE_EXTENSION, segmentSeq);
+        segment = LittleFS.open(path, "w");
+        if (!segment) {
+            stats.writeErrors++;
+            writer.finish(blockBuffer);  // Drop the block rather than retry forever
+            return;
+        }
+        capture_write_file_header(blockBuffer);
+        offset = CAPTURE_FILE_HEADER_BYTES;
+        stats.segments++;
+    }
+
+    size_t raw = writer.getRawBytes();
+    size_t n = offset + writer.finish(blockBuffer + offset);
+    if (segment.write(blockBuffer, n) != n) {
+        stats.writeErrors++;
+        segment.close();  // Whatever made it is readable up to the partial block
+        return;
+    }
+    segment.flush();  // ✅ Committed: survives a crash or power loss from here on
+    stats.blocks++;
+    stats.rawBytes += raw;
+    stats.flashBytes += n;
+
+    if (segment.size() >= CAPTURE_SEGMENT_MAX_BYTES) {
+        segment.close();
+        segmentActive = false;
+    }
+}
+
+static void closeSegment() {
+    if (writer.getFrames()) writeBlock();
+    if (segment) segment.close();
+    segmentActive = false;
+}
+
+static void appendItem(const CaptureItem &item, uint32_t nowMs) {
+    if (item.arrivalUs < lastArrivalUs) arrivalHighUs += 1ULL << 32;
+    lastArrivalUs = item.arrivalUs;
+    uint64_t timestampUs = arrivalHighUs | item.arrivalUs;
+
+    if (!segmentActive) {
+        segmentActive = true;
+        segmentStartMs = nowMs;
+    }
+    if (writer.getFrames() == 0) blockStartMs = nowMs;
+    if (!writer.add(timestampUs, item.source, item.frame, item.length)) {
+        writeBlock();
+        blockStartMs = nowMs;
+        writer.add(timestampUs, item.source, item.frame, item.length);
+    }
+    stats.frames++;
+}
+
+static void recorderTask(void *arg) {
+    if (!mountFilesystem()) {
+        enabled = false;
+        vTaskDelete(nullptr);
+        return;
+    }
+    mounted = true;
+
+    for (;;) {
+        CaptureItem item;
+        bool received = xQueueReceive(captureQueue, &item, pdMS_TO_TICKS(CAPTURE_POLL_MS)) == pdTRUE;
+        uint32_t nowMs = millis();
+        while (received) {
+            appendItem(item, nowMs);
+            received = xQueueReceive(captureQueue, &item, 0) == pdTRUE;
+        }
+
+        if (!enabled) {
+            if (segmentActive) closeSegment();  // Keep what was recorded before CAPTURE OFF
+            continue;
+        }
+        if (segmentActive && nowMs - segmentStartMs >= CAPTURE_SEGMENT_SECONDS * 1000UL) {
+            closeSegment();
+        } else if (writer.getFrames() && nowMs - blockStartMs >= CAPTURE_FLUSH_INTERVAL_MS) {
+            writeBlock();
+        }
+    }
+}
+
+void capture_start() {
+    if (captureQueue) return;
+    preferences.begin("ble_ftms", true);
+    enabled = preferences.getBool("capture", CAPTURE_DEFAULT_ENABLED);
+    preferences.end();
+
+    captureQueue = xQueueCreate(CAPTURE_QUEUE_LENGTH, sizeof(CaptureItem));
+    xTaskCreate(recorderTask, "capture", CAPTURE_STACK, nullptr, CAPTURE_PRIORITY, nullptr);
+    LOGF("[INFO] Capture recorder %s, last %d minutes", enabled ? "on" : "off", CAPTURE_MINUTES);
+}
+
+void capture_set_enabled(bool on, bool persist) {
+    enabled = on;
+    if (persist) {
+        preferences.begin("ble_ftms", false);
+        preferences.putBool("capture", on);
+        preferences.end();
+    }
+    LOGF("[INFO] Capture recorder %s", on ? "on" : "off");
+}
+
+bool capture_is_enabled() {
+    return enabled;
+}
+
+void capture_record(const ANTFrame &frame, CaptureSource source, uint32_t arrivalUs) {
+    if (!enabled || !captureQueue) return;
+
+    // ✅ The decoder already checked the xor; rebuild the frame as it came in
+    CaptureItem item;
+    item.arrivalUs = arrivalUs;
+    item.source = source;
+    item.length = frame.length + ANT_FRAME_OVERHEAD;
+    item.frame[0] = frame.sync;
+    item.frame[1] = frame.deviceType;
+    item.frame[2] = frame.length;
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < frame.length; i++) {
+        item.frame[3 + i] = frame.payload[i];
+        crc ^= frame.payload[i];
+    }
+    item.frame[3 + frame.length] = crc;
+
+    if (xQueueSend(captureQueue, &item, 0) != pdTRUE) stats.queueDrops++;
+}
+
+size_t capture_list_json(char *out, size_t size) {
+    size_t n = 0;
+    auto append = [&](const char *format, auto... args) {
+        if (n >= size) return;
+        int written = snprintf(out + n, size - n, format, args...);
+        if (written > 0) n += written;
+    };
+
+    append("{\"type\":\"captures\",\"segments\":[");
+    File dir = mounted ? LittleFS.open(CAPTURE_DIR) : File();
+    bool first = true;
+    if (dir && dir.isDirectory()) {
+        for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+            append("%s{\"name\":\"%s\",\"bytes\":%u}", first ? "" : ",", file.name(), (unsigned)file.size());
+            file.close();
+            first = false;
+        }
+    }
+    append("]}");
+
+    if (n >= size) {
+        if (size) out[0] = '\0';
+        return 0;
+    }
+    return n;
+}
+
+const CaptureStats &capture_get_stats() {
+    return stats;
+}
+
+void capture_log_stats() {
+    LOGF("[CAP] frames: %u, blocks: %u, raw: %u B, flash: %u B, segments: %u, queue drops: %u, errors: %u",
+         stats.frames, stats.blocks, stats.rawBytes, stats.flashBytes, stats.segments, stats.queueDrops,
+         stats.writeErrors);
+}
@@ -0,0 +1,53 @@
+#ifndef CAPTURE_RECORDER_H
+#define CAPTURE_RECORDER_H
+
+#include <Arduino.h>
+#include "ant_capture.h"
+
+// ✅ Flight recorder for ingested ANT+ frames: the last CAPTURE_MINUTES of frames, in
+// the capture format of ant_capture.h, kept in a ring of segment files on LittleFS
+// (CAPTURE_DIR/<seq>.acap, the oldest deleted as a new one starts). The parse task
+// only copies each frame into a queue; a low-priority task compresses whole blocks
+// and appends each with a single write, so flash sees one write per ~4 KB of frames
+// (or per CAPTURE_FLUSH_INTERVAL_MS when data is slow) instead of one per frame.
+// Segments are served over HTTP at /capture/<seq>.acap; /capture lists them.
+
+#ifndef CAPTURE_DEFAULT_ENABLED
+    #define CAPTURE_DEFAULT_ENABLED 1  // CAPTURE ON/OFF overrides it, stored in flash
+#endif
+#ifndef CAPTURE_MINUTES
+    #define CAPTURE_MINUTES 10
+#endif
+
+#define CAPTURE_DIR "/capture"
+#define CAPTURE_EXTENSION ".acap"
+#define CAPTURE_SEGMENT_SECONDS 60
+#define CAPTURE_SEGMENTS (CAPTURE_MINUTES + 1)  // The one being written is partial
+#define CAPTURE_SEGMENT_MAX_BYTES 65536        // Caps flash use at a high frame rate
+#define CAPTURE_FLUSH_INTERVAL_MS 30000  // A partial block goes to flash at least this often
+#define CAPTURE_QUEUE_LENGTH 64          // Parse task → recorder task, ~3 s of frames
+#define CAPTURE_POLL_MS 500
+#define CAPTURE_PRIORITY 1
+#define CAPTURE_STACK 6144  // The compressor keeps its 2 KB match table on the stack
+
+struct CaptureStats {
+    uint32_t frames;       // Frames added to blocks
+    uint32_t queueDrops;   // Recorder behind or not mounted yet: frames lost
+    uint32_t blocks;       // Blocks written
+    uint32_t rawBytes;     // Record bytes before compression
+    uint32_t flashBytes;   // Bytes written to files, headers included
+    uint32_t segments;     // Segment files started
+    uint32_t writeErrors;
+};
+
+void capture_start();  // ✅ Mounts LittleFS on the recorder task, never blocks boot
+void capture_set_enabled(bool enabled, bool persist = true);
+bool capture_is_enabled();
+// ✅ ANTParser frame tap (parsing task); never blocks
+void capture_record(const ANTFrame &frame, CaptureSource source, uint32_t arrivalUs);
+// {"type":"captures","segments":[{"name":"00000012.acap","bytes":1234},...]}; 0 if it didn't fit
+size_t capture_list_json(char *out, size_t size);
+const CaptureStats &capture_get_stats();
+void capture_log_stats();
+
+#endif  // CAPTURE_RECORDER_H
@@ -0,0 +1,45 @@
+#include "crc16.h"
+#include <array>
+
+// ✅ 256-entry tables, built at compile time (live in flash)
+static constexpr std::array<uint16_t, 256> buildCcittTable() {
+    std::array<uint16_t, 256> table = {};
+    for (uint16_t i = 0; i < 256; i++) {
+        uint16_t crc = i << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+// ✅ Reflected: bits go in and out least significant first
+static constexpr std::array<uint16_t, 256> buildArcTable() {
+    std::array<uint16_t, 256> table = {};
+    for (uint16_t i = 0; i < 256; i++) {
+        uint16_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+static constexpr std::array<uint16_t, 256> CCITT_TABLE = buildCcittTable();
+static constexpr std::array<uint16_t, 256> ARC_TABLE = buildArcTable();
+
+uint16_t crc16_ccitt(const uint8_t *data, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc << 8) ^ CCITT_TABLE[(crc >> 8) ^ data[i]];
+    }
+    return crc;
+}
+
+uint16_t crc16_arc(const uint8_t *data, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 8) ^ ARC_TABLE[(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
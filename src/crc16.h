@@ -0,0 +1,13 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <Arduino.h>
+
+// ✅ CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, no reflection, no final xor), as
+// used by serial link v2 packets and ride file blocks. Pass the previous result as
+// `crc` to continue over several spans.
+uint16_t crc16_ccitt(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF);
+// ✅ CRC-16/ARC (poly 0x8005 reflected, init 0), the CRC of FIT files
+uint16_t crc16_arc(const uint8_t *data, size_t len, uint16_t crc = 0);
+
+#endif  // CRC16_H
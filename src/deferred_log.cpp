@@ -0,0 +1,195 @@
+#include "deferred_log.h"
+#include "logger.h"
+
+#define LOG_DRAIN_PRIORITY 1        // Just above idle: never competes with the data path
+#define LOG_DRAIN_STACK 4096
+#define LOG_DRAIN_BATCH 16          // Records per wake-up
+#define LOG_DRAIN_IDLE_MS 20
+
+DeferredLog deferredLog;
+
+#ifndef DEBUG
+NullLogger logger;
+#endif
+
+// ✅ The last byte of `text` is never handed out: it stays a '\0' shared by every
+// argument that finds no room, so those print as "" instead of reading past the array
+uint8_t LogRecord::addText(const char *value) {
+    if (!value) value = "(null)";
+    size_t room = LOG_TEXT_BYTES - 1 - textUsed;
+    if (room == 0) {
+        text[LOG_TEXT_BYTES - 1] = '\0';
+        return LOG_TEXT_BYTES - 1;
+    }
+
+    size_t len = strlen(value);
+    if (len >= room) len = room - 1;  // Truncate, keep the terminator
+    uint8_t offset = textUsed;
+    memcpy(text + offset, value, len);
+    text[offset + len] = '\0';
+    textUsed += len + 1;
+    return offset;
+}
+
+DeferredLog::DeferredLog() : enqueuePos(0), dropped(0), dequeuePos(0), reportedDropped(0) {
+    for (uint32_t i = 0; i < LOG_RING_SLOTS; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    stats = {};
+}
+
+// ✅ A slot is free for position `pos` when its sequence equals pos, and readable
+// when it equals pos + 1 (bounded MPMC queue, used here with a single consumer)
+LogRecord *DeferredLog::reserve() {
+    uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot &slot = slots[pos & (LOG_RING_SLOTS - 1)];
+        uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(sequence - pos);
+
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                return &slot.record;
+            }
+        } else if (diff < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);  // Full: the drain is behind
+            return nullptr;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void DeferredLog::commit(LogRecord *record) {
+    Slot *slot = reinterpret_cast<Slot *>(reinterpret_cast<uint8_t *>(record) - offsetof(Slot, record));
+    slot->sequence.store(slot->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// ✅ Re-runs each conversion of the format with the stored argument cast to the type
+// printf expects for that conversion and length modifier, so output matches LOGF exactly
+size_t DeferredLog::format(const LogRecord &record, char *line, size_t size) {
+    uint32_t ms = record.timestampUs / 1000;
+    size_t out = snprintf(line, size, "[%u.%03u] ", (unsigned)(ms / 1000), (unsigned)(ms % 1000));
+
+    if (record.verbatim) {
+        const char *message = record.format ? record.format : record.text;
+        out += snprintf(line + out, size - out, "%s", message);
+        return out < size ? out : size - 1;
+    }
+
+    const char *f = record.format;
+    uint8_t arg = 0;
+    while (*f && out < size - 1) {
+        if (*f != '%') {
+            line[out++] = *f++;
+            continue;
+        }
+        if (f[1] == '%') {
+            line[out++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // Copy one conversion spec: %[flags][width][.precision][length]conversion
+        char spec[16];
+        uint8_t n = 0;
+        spec[n++] = *f++;
+        while (*f && strchr("-+ #0123456789.", *f) && n < sizeof(spec) - 4) spec[n++] = *f++;
+        uint8_t longs = 0;
+        bool sizeT = false;
+        while (*f && strchr("hlzjtL", *f) && n < sizeof(spec) - 2) {
+            if (*f == 'l') longs++;
+            if (*f == 'z' || *f == 'j' || *f == 't') sizeT = true;
+            spec[n++] = *f++;
+        }
+        char conversion = *f ? *f++ : 'd';
+        spec[n++] = conversion;
+        spec[n] = '\0';
+
+        if (arg >= record.argCount) break;  // More conversions than arguments
+        LogArg type = record.types[arg];
+        const auto &value = record.args[arg++];
+        int64_t integer = type == LogArg::Double ? (int64_t)value.d : value.s;
+        size_t room = size - out;
+        int written;
+
+        switch (conversion) {
+            case 'd': case 'i':
+                if (longs >= 2 || sizeT) written = snprintf(line + out, room, spec, (long long)integer);
+                else if (longs == 1) written = snprintf(line + out, room, spec, (long)integer);
+                else written = snprintf(line + out, room, spec, (int)integer);
+                break;
+            case 'u': case 'x': case 'X': case 'o':
+                if (longs >= 2 || sizeT) written = snprintf(line + out, room, spec, (unsigned long long)integer);
+                else if (longs == 1) written = snprintf(line + out, room, spec, (unsigned long)integer);
+                else written = snprintf(line + out, room, spec, (unsigned int)integer);
+                break;
+            case 'c':
+                written = snprintf(line + out, room, spec, (int)integer);
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                written = snprintf(line + out, room, spec,
+                                   type == LogArg::Double ? value.d : (double)integer);
+                break;
+            case 's':
+                written = snprintf(line + out, room, spec,
+                                   type == LogArg::Text ? record.text + value.textOffset : "?");
+                break;
+            case 'p':
+                written = snprintf(line + out, room, spec, value.p);
+                break;
+            default:
+                written = snprintf(line + out, room, "%s", spec);
+                break;
+        }
+        if (written > 0) out += (size_t)written < room ? written : room - 1;
+    }
+
+    line[out < size ? out : size - 1] = '\0';
+    return out < size ? out : size - 1;
+}
+
+size_t DeferredLog::drain(HardwareSerial &out, size_t maxRecords) {
+    char line[LOG_LINE_BYTES];
+    size_t drained = 0;
+
+    uint32_t droppedNow = getDropped();
+    if (droppedNow != reportedDropped) {
+        int len = snprintf(line, sizeof(line), "[WARN] Log ring full: %u messages dropped\r\n",
+                           (unsigned)(droppedNow - reportedDropped));
+        out.write((const uint8_t *)line, len);
+        reportedDropped = droppedNow;
+    }
+
+    while (drained < maxRecords) {
+        Slot &slot = slots[dequeuePos & (LOG_RING_SLOTS - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) break;  // Empty
+
+        size_t len = format(slot.record, line, sizeof(line) - 2);
+        slot.sequence.store(dequeuePos + LOG_RING_SLOTS, std::memory_order_release);  // Hand the slot back
+        dequeuePos++;
+
+        line[len++] = '\r';
+        line[len++] = '\n';
+        out.write((const uint8_t *)line, len);
+        stats.written++;
+        drained++;
+    }
+    stats.dropped = droppedNow;
+    return drained;
+}
+
+#ifndef NATIVE_BUILD
+static void logDrainTask(void *arg) {
+    HardwareSerial *port = static_cast<HardwareSerial *>(arg);
+    for (;;) {
+        if (deferredLog.drain(*port, LOG_DRAIN_BATCH) == 0) {
+            vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_IDLE_MS));
+        }
+    }
+}
+
+void log_start(HardwareSerial &port) {
+    xTaskCreate(logDrainTask, "log_drain", LOG_DRAIN_STACK, &port, LOG_DRAIN_PRIORITY, nullptr);
+}
+#endif
@@ -0,0 +1,171 @@
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <type_traits>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_RING_SLOTS
+    #define LOG_RING_SLOTS 64  // Must be a power of two
+#endif
+#define LOG_MAX_ARGS 16    // prepareFTMSData dumps 10 bytes per line
+#define LOG_TEXT_BYTES 48  // Copied %s arguments and LOG(String) text; longer is truncated
+#define LOG_LINE_BYTES 256
+
+enum class LogArg : uint8_t { Signed, Unsigned, Double, Text, Pointer };
+
+// ✅ One log call, unformatted: the format string pointer is the message id (literals
+// live for the whole program), arguments are kept raw. Strings are the exception and
+// are copied, since c_str() of a temporary won't survive until the drain.
+struct LogRecord {
+    const char *format;
+    uint32_t timestampUs;
+    uint8_t level;
+    uint8_t argCount;
+    uint8_t textUsed;
+    bool verbatim;  // LOG(x): print `format` (or `text`) as is, no conversions
+    LogArg types[LOG_MAX_ARGS];
+    union {
+        int64_t s;
+        uint64_t u;
+        double d;
+        const void *p;
+        uint8_t textOffset;
+    } args[LOG_MAX_ARGS];
+    char text[LOG_TEXT_BYTES];
+
+    uint8_t addText(const char *value);  // Offset of the copy in `text`
+};
+
+struct DeferredLogStats {
+    uint32_t written;  // Records formatted and printed
+    uint32_t dropped;  // Log calls that found the ring full
+};
+
+// ✅ Bounded multi-producer / single-consumer ring of LogRecord slots. Any task may
+// log (reserve + commit is a CAS and a few stores, no lock, no formatting); only the
+// drain task formats and prints. When the ring is full the message is dropped and
+// counted instead of blocking the caller.
+class DeferredLog {
+public:
+    DeferredLog();
+    LogRecord *reserve();  // nullptr when full
+    void commit(LogRecord *record);
+    size_t drain(HardwareSerial &out, size_t maxRecords);  // Single consumer
+    static size_t format(const LogRecord &record, char *line, size_t size);
+
+    const DeferredLogStats &getStats() const { return stats; }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        LogRecord record;
+    };
+
+    Slot slots[LOG_RING_SLOTS];
+    std::atomic<uint32_t> enqueuePos;
+    std::atomic<uint32_t> dropped;
+    uint32_t dequeuePos;
+    uint32_t reportedDropped;
+    DeferredLogStats stats;
+};
+
+extern DeferredLog deferredLog;
+
+// Starts the low-priority task that drains the ring into `port`
+void log_start(HardwareSerial &port);
+
+// ✅ Level from the message prefix, at compile time for literals
+constexpr bool logHasPrefix(const char *s, const char *prefix) {
+    return *prefix == '\0' || (*s == *prefix && logHasPrefix(s + 1, prefix + 1));
+}
+
+constexpr uint8_t logLevelOf(const char *message) {
+    return logHasPrefix(message, "[ERROR]") ? LOG_LEVEL_ERROR :
+           logHasPrefix(message, "[WARN]") ? LOG_LEVEL_WARN :
+           logHasPrefix(message, "[DEBUG]") ? LOG_LEVEL_DEBUG : LOG_LEVEL_INFO;
+}
+
+inline uint8_t logLevelOf(const String &message) {
+    return logLevelOf(message.c_str());
+}
+
+template<typename T>
+inline void logPackArg(LogRecord &record, const T &value) {
+    if (record.argCount >= LOG_MAX_ARGS) return;
+    uint8_t i = record.argCount++;
+
+    if constexpr (std::is_floating_point<T>::value) {
+        record.types[i] = LogArg::Double;
+        record.args[i].d = value;
+    } else if constexpr (std::is_enum<T>::value) {
+        record.types[i] = LogArg::Signed;
+        record.args[i].s = (int64_t)value;
+    } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        record.types[i] = LogArg::Signed;
+        record.args[i].s = value;
+    } else if constexpr (std::is_integral<T>::value) {
+        record.types[i] = LogArg::Unsigned;
+        record.args[i].u = value;
+    } else if constexpr (std::is_convertible<T, const char *>::value) {
+        record.types[i] = LogArg::Text;
+        record.args[i].textOffset = record.addText(value);
+    } else if constexpr (std::is_same<T, String>::value) {
+        record.types[i] = LogArg::Text;
+        record.args[i].textOffset = record.addText(value.c_str());
+    } else {
+        static_assert(std::is_pointer<T>::value, "Unsupported LOGF argument type");
+        record.types[i] = LogArg::Pointer;
+        record.args[i].p = value;
+    }
+}
+
+template<typename... Args>
+inline void logDeferred(uint8_t level, const char *format, const Args &... args) {
+    LogRecord *record = deferredLog.reserve();
+    if (!record) return;
+    record->format = format;
+    record->timestampUs = micros();
+    record->level = level;
+    record->argCount = 0;
+    record->textUsed = 0;
+    record->verbatim = false;
+    (logPackArg(*record, args), ...);
+    deferredLog.commit(record);
+}
+
+// LOG(x) with a string literal: only the pointer is stored
+inline void logDeferredText(uint8_t level, const char *message) {
+    LogRecord *record = deferredLog.reserve();
+    if (!record) return;
+    record->format = message;
+    record->timestampUs = micros();
+    record->level = level;
+    record->argCount = 0;
+    record->textUsed = 0;
+    record->verbatim = true;
+    deferredLog.commit(record);
+}
+
+// LOG(x) with a String: the text is copied
+inline void logDeferredText(uint8_t level, const String &message) {
+    LogRecord *record = deferredLog.reserve();
+    if (!record) return;
+    record->format = nullptr;
+    record->timestampUs = micros();
+    record->level = level;
+    record->argCount = 0;
+    record->textUsed = 0;
+    record->verbatim = true;
+    record->addText(message.c_str());
+    deferredLog.commit(record);
+}
+
+#endif  // DEFERRED_LOG_H
@@ -0,0 +1,399 @@
+#include "fit_export.h"
+#include <algorithm>
+#include "crc16.h"
+#include "session_totals.h"
+
+#define FIT_INVALID 0xFFFFFFFF  // Cut to the field size: the invalid value of every unsigned type
+
+// Base types
+#define FIT_ENUM 0x00
+#define FIT_UINT8 0x02
+#define FIT_UINT16 0x84
+#define FIT_UINT32 0x86
+
+// Profile values
+#define FIT_FILE_ACTIVITY 4
+#define FIT_EVENT_TIMER 0
+#define FIT_EVENT_SESSION 8
+#define FIT_EVENT_LAP 9
+#define FIT_EVENT_ACTIVITY 26
+#define FIT_EVENT_TYPE_START 0
+#define FIT_EVENT_TYPE_STOP 1
+#define FIT_EVENT_TYPE_STOP_ALL 4
+#define FIT_SPORT_CYCLING 2
+#define FIT_SUB_SPORT_INDOOR_CYCLING 6
+#define FIT_ACTIVITY_MANUAL 0
+
+#define FIT_DEFINITION_FLAG 0x40
+
+struct FitField {
+    uint8_t number;
+    uint8_t size;
+    uint8_t baseType;
+};
+
+// ✅ One local message type per global message, defined once; values are written in
+// field order
+struct FitMessage {
+    uint16_t global;
+    uint8_t local;
+    const FitField *fields;
+    uint8_t count;
+};
+
+static const FitField FILE_ID_FIELDS[] = {
+    {0, 1, FIT_ENUM},     // type
+    {1, 2, FIT_UINT16},   // manufacturer
+    {2, 2, FIT_UINT16},   // product
+    {4, 4, FIT_UINT32},   // time_created
+};
+static const FitField EVENT_FIELDS[] = {
+    {253, 4, FIT_UINT32}, // timestamp
+    {0, 1, FIT_ENUM},     // event
+    {1, 1, FIT_ENUM},     // event_type
+    {4, 1, FIT_UINT8},    // event_group
+};
+static const FitField RECORD_FIELDS[] = {
+    {253, 4, FIT_UINT32}, // timestamp
+    {5, 4, FIT_UINT32},   // distance, 0.01 m
+    {29, 4, FIT_UINT32},  // accumulated_power, W (1 Hz: J)
+    {6, 2, FIT_UINT16},   // speed, mm/s
+    {7, 2, FIT_UINT16},   // power, W
+    {3, 1, FIT_UINT8},    // heart_rate, bpm
+    {4, 1, FIT_UINT8},    // cadence, rpm
+};
+static const FitField LAP_FIELDS[] = {
+    {253, 4, FIT_UINT32}, // timestamp
+    {2, 4, FIT_UINT32},   // start_time
+    {7, 4, FIT_UINT32},   // total_elapsed_time, ms
+    {8, 4, FIT_UINT32},   // total_timer_time, ms
+    {9, 4, FIT_UINT32},   // total_distance, 0.01 m
+    {11, 2, FIT_UINT16},  // total_calories, kcal
+    {13, 2, FIT_UINT16},  // avg_speed, mm/s
+    {14, 2, FIT_UINT16},  // max_speed
+    {19, 2, FIT_UINT16},  // avg_power, W
+    {20, 2, FIT_UINT16},  // max_power
+    {15, 1, FIT_UINT8},   // avg_heart_rate, bpm
+    {16, 1, FIT_UINT8},   // max_heart_rate
+    {17, 1, FIT_UINT8},   // avg_cadence, rpm
+    {18, 1, FIT_UINT8},   // max_cadence
+    {0, 1, FIT_ENUM},     // event
+    {1, 1, FIT_ENUM},     // event_type
+    {25, 1, FIT_ENUM},    // sport
+};
+static const FitField SESSION_FIELDS[] = {
+    {253, 4, FIT_UINT32}, // timestamp
+    {2, 4, FIT_UINT32},   // start_time
+    {7, 4, FIT_UINT32},   // total_elapsed_time, ms
+    {8, 4, FIT_UINT32},   // total_timer_time, ms
+    {9, 4, FIT_UINT32},   // total_distance, 0.01 m
+    {11, 2, FIT_UINT16},  // total_calories, kcal
+    {14, 2, FIT_UINT16},  // avg_speed, mm/s
+    {15, 2, FIT_UINT16},  // max_speed
+    {20, 2, FIT_UINT16},  // avg_power, W
+    {21, 2, FIT_UINT16},  // max_power
+    {25, 2, FIT_UINT16},  // first_lap_index
+    {26, 2, FIT_UINT16},  // num_laps
+    {16, 1, FIT_UINT8},   // avg_heart_rate, bpm
+    {17, 1, FIT_UINT8},   // max_heart_rate
+    {18, 1, FIT_UINT8},   // avg_cadence, rpm
+    {19, 1, FIT_UINT8},   // max_cadence
+    {0, 1, FIT_ENUM},     // event
+    {1, 1, FIT_ENUM},     // event_type
+    {5, 1, FIT_ENUM},     // sport
+    {6, 1, FIT_ENUM},     // sub_sport
+};
+static const FitField ACTIVITY_FIELDS[] = {
+    {253, 4, FIT_UINT32}, // timestamp
+    {0, 4, FIT_UINT32},   // total_timer_time, ms
+    {1, 2, FIT_UINT16},   // num_sessions
+    {2, 1, FIT_ENUM},     // type
+    {3, 1, FIT_ENUM},     // event
+    {4, 1, FIT_ENUM},     // event_type
+};
+
+#define FIT_MESSAGE(global, local, fields) {global, local, fields, sizeof(fields) / sizeof(fields[0])}
+static const FitMessage FILE_ID = FIT_MESSAGE(0, 0, FILE_ID_FIELDS);
+static const FitMessage EVENT = FIT_MESSAGE(21, 1, EVENT_FIELDS);
+static const FitMessage RECORD = FIT_MESSAGE(20, 2, RECORD_FIELDS);
+static const FitMessage LAP = FIT_MESSAGE(19, 3, LAP_FIELDS);
+static const FitMessage SESSION = FIT_MESSAGE(18, 4, SESSION_FIELDS);
+static const FitMessage ACTIVITY = FIT_MESSAGE(34, 5, ACTIVITY_FIELDS);
+
+static size_t definitionBytes(const FitMessage &message) {
+    return 6 + 3 * message.count;
+}
+
+static size_t messageBytes(const FitMessage &message) {
+    size_t n = 1;
+    for (uint8_t i = 0; i < message.count; i++) n += message.fields[i].size;
+    return n;
+}
+
+static size_t writeDefinition(uint8_t *out, const FitMessage &message) {
+    uint8_t *p = out;
+    *p++ = FIT_DEFINITION_FLAG | message.local;
+    *p++ = 0;  // Reserved
+    *p++ = 0;  // Little-endian
+    *p++ = message.global & 0xFF;
+    *p++ = message.global >> 8;
+    *p++ = message.count;
+    for (uint8_t i = 0; i < message.count; i++) {
+        *p++ = message.fields[i].number;
+        *p++ = message.fields[i].size;
+        *p++ = message.fields[i].baseType;
+    }
+    return p - out;
+}
+
+// `values` in field order, one per field
+static size_t writeMessage(uint8_t *out, const FitMessage &message, const uint32_t *values) {
+    uint8_t *p = out;
+    *p++ = message.local;
+    for (uint8_t i = 0; i < message.count; i++) {
+        for (uint8_t b = 0; b < message.fields[i].size; b++) *p++ = (values[i] >> (8 * b)) & 0xFF;
+    }
+    return p - out;
+}
+
+static uint32_t average(uint64_t sum, uint32_t count) {
+    return count ? (uint32_t)((sum + count / 2) / count) : FIT_INVALID;
+}
+
+static inline uint32_t speedMmPerSecond(uint16_t speed) {
+    return (speed * 10u + 18) / 36;  // 0.01 km/h
+}
+
+FitEncoder::FitEncoder()
+    : stage(Stage::Done), stagedLen(0), stagedPos(0), crc(0), samples(0), pauses(0), timeOffset(0), dataBytes(0),
+      emitted(0), padded(0), pausesEmitted(0) {}
+
+bool FitEncoder::begin(RideReader::ReadFn read, void *context, const RideSummary &summary) {
+    stage = Stage::Done;
+    samples = summary.samples;
+    pauses = summary.pauses;
+    timeOffset = summary.unixStart >= FIT_EPOCH_UNIX ? summary.unixStart - FIT_EPOCH_UNIX : 0;
+    dataBytes = definitionBytes(FILE_ID) + messageBytes(FILE_ID) + definitionBytes(EVENT) + messageBytes(EVENT) +
+                definitionBytes(RECORD) + samples * messageBytes(RECORD) + pauses * 2 * messageBytes(EVENT) +
+                messageBytes(EVENT) + definitionBytes(LAP) + messageBytes(LAP) + definitionBytes(SESSION) +
+                messageBytes(SESSION) + definitionBytes(ACTIVITY) + messageBytes(ACTIVITY);
+    if (samples == 0 || !reader.open(read, context)) return false;
+
+    stage = Stage::Header;
+    stagedLen = stagedPos = 0;
+    crc = 0;
+    emitted = padded = pausesEmitted = 0;
+    firstSecond = lastSecond = 0;
+    lastDistance = lastEnergy = distanceBase = energyBase = distance = energy = 0;
+    powerSum = speedSum = 0;
+    cadenceSum = cadenceCount = heartRateSum = heartRateCount = 0;
+    maxPower = maxSpeed = 0;
+    maxCadence = maxHeartRate = 0;
+    return true;
+}
+
+size_t FitEncoder::read(uint8_t *out, size_t len) {
+    size_t n = 0;
+    while (n < len) {
+        if (stagedPos == stagedLen && !stageNext()) break;
+        size_t chunk = std::min(len - n, stagedLen - stagedPos);
+        memcpy(out + n, staged + stagedPos, chunk);
+        stagedPos += chunk;
+        n += chunk;
+    }
+    return n;
+}
+
+// ✅ Stages the next run of messages; false at the end of the file
+bool FitEncoder::stageNext() {
+    stagedLen = stagedPos = 0;
+
+    switch (stage) {
+    case Stage::Header:
+        staged[0] = FIT_HEADER_BYTES;
+        staged[1] = FIT_PROTOCOL_VERSION;
+        staged[2] = FIT_PROFILE_VERSION & 0xFF;
+        staged[3] = FIT_PROFILE_VERSION >> 8;
+        for (int i = 0; i < 4; i++) staged[4 + i] = (dataBytes >> (8 * i)) & 0xFF;
+        memcpy(staged + 8, ".FIT", 4);
+        {
+            uint16_t headerCrc = crc16_arc(staged, 12);
+            staged[12] = headerCrc & 0xFF;
+            staged[13] = headerCrc >> 8;
+        }
+        stagedLen = FIT_HEADER_BYTES;
+        stage = Stage::Start;
+        break;
+
+    case Stage::Start: {
+        uint32_t fileId[] = {FIT_FILE_ACTIVITY, FIT_MANUFACTURER_DEVELOPMENT, FIT_PRODUCT_ID, timestamp(0)};
+        uint32_t start[] = {timestamp(0), FIT_EVENT_TIMER, FIT_EVENT_TYPE_START, 0};
+        stagedLen += writeDefinition(staged + stagedLen, FILE_ID);
+        stagedLen += writeMessage(staged + stagedLen, FILE_ID, fileId);
+        stagedLen += writeDefinition(staged + stagedLen, EVENT);
+        stagedLen += writeMessage(staged + stagedLen, EVENT, start);
+        stagedLen += writeDefinition(staged + stagedLen, RECORD);
+        stage = Stage::Records;
+        break;
+    }
+
+    case Stage::Records: {
+        RideSample sample;
+        if (emitted < samples && padded == 0 && reader.next(sample)) {
+            stageRecord(sample);
+            break;
+        }
+        // ✅ Fewer samples than the summary (blocks skipped for their CRC): make up the
+        // declared records and pause events so the data size in the header holds
+        if (emitted + padded < samples) {
+            if (emitted == 0) {
+                uint32_t empty[] = {timestamp(0), 0, 0, 0, 0, FIT_INVALID, 0};
+                memcpy(lastRecord, empty, sizeof(lastRecord));
+            }
+            stagedLen += writeMessage(staged + stagedLen, RECORD, lastRecord);
+            padded++;
+            break;
+        }
+        if (pausesEmitted < pauses) {
+            stagedLen += writePause(staged + stagedLen, lastSecond, lastSecond);
+            break;
+        }
+        stage = Stage::Lap;
+        return stageNext();
+    }
+
+    case Stage::Lap: {
+        uint32_t stop[] = {timestamp(lastSecond), FIT_EVENT_TIMER, FIT_EVENT_TYPE_STOP_ALL, 0};
+        stagedLen += writeMessage(staged + stagedLen, EVENT, stop);
+        stagedLen += writeDefinition(staged + stagedLen, LAP);
+        stagedLen += writeSummary(staged + stagedLen, true);
+        stage = Stage::Session;
+        break;
+    }
+
+    case Stage::Session:
+        stagedLen += writeDefinition(staged + stagedLen, SESSION);
+        stagedLen += writeSummary(staged + stagedLen, false);
+        stage = Stage::Activity;
+        break;
+
+    case Stage::Activity: {
+        uint32_t activity[] = {timestamp(lastSecond), getTimerMs(), 1, FIT_ACTIVITY_MANUAL, FIT_EVENT_ACTIVITY,
+                               FIT_EVENT_TYPE_STOP};
+        stagedLen += writeDefinition(staged + stagedLen, ACTIVITY);
+        stagedLen += writeMessage(staged + stagedLen, ACTIVITY, activity);
+        stage = Stage::Crc;
+        break;
+    }
+
+    case Stage::Crc:
+        // Over the header and the data, which went into it as they were staged
+        staged[0] = crc & 0xFF;
+        staged[1] = crc >> 8;
+        stagedLen = FIT_CRC_BYTES;
+        stage = Stage::Done;
+        return true;
+
+    case Stage::Done:
+        return false;
+    }
+
+    crc = crc16_arc(staged, stagedLen, crc);
+    return true;
+}
+
+void FitEncoder::stageRecord(const RideSample &sample) {
+    if (emitted == 0) {
+        firstSecond = sample.second;
+    } else if (sample.second - lastSecond > 1 && pausesEmitted < pauses) {
+        stagedLen += writePause(staged + stagedLen, lastSecond, sample.second);
+    }
+
+    // Totals restart with a new BLE session: keep them climbing across it
+    if (sample.distance < lastDistance) distanceBase += lastDistance;
+    if (sample.energy < lastEnergy) energyBase += lastEnergy;
+    lastDistance = sample.distance;
+    lastEnergy = sample.energy;
+    distance = distanceBase + sample.distance;
+    energy = energyBase + sample.energy;
+
+    uint32_t speed = speedMmPerSecond(sample.speed);
+    uint32_t record[] = {
+        timestamp(sample.second),
+        distance * 100,
+        energy,
+        speed,
+        sample.power,
+        sample.heartRate ? sample.heartRate : FIT_INVALID,  // 0: no strap
+        sample.cadence,
+    };
+    static_assert(sizeof(record) == sizeof(lastRecord), "record");
+    stagedLen += writeMessage(staged + stagedLen, RECORD, record);
+    memcpy(lastRecord, record, sizeof(lastRecord));
+
+    powerSum += sample.power;
+    speedSum += speed;
+    if (sample.cadence) {
+        cadenceSum += sample.cadence;
+        cadenceCount++;
+    }
+    if (sample.heartRate) {
+        heartRateSum += sample.heartRate;
+        heartRateCount++;
+    }
+    if (sample.power > maxPower) maxPower = sample.power;
+    if (speed > maxSpeed) maxSpeed = speed;
+    if (sample.cadence > maxCadence) maxCadence = sample.cadence;
+    if (sample.heartRate > maxHeartRate) maxHeartRate = sample.heartRate;
+
+    lastSecond = sample.second;
+    emitted++;
+}
+
+// ✅ A pause: the timer stopped at the last second ridden, restarts at `resumed`
+size_t FitEncoder::writePause(uint8_t *out, uint32_t stopped, uint32_t resumed) {
+    uint32_t stop[] = {timestamp(stopped), FIT_EVENT_TIMER, FIT_EVENT_TYPE_STOP_ALL, 0};
+    uint32_t start[] = {timestamp(resumed), FIT_EVENT_TIMER, FIT_EVENT_TYPE_START, 0};
+    size_t n = writeMessage(out, EVENT, stop);
+    n += writeMessage(out + n, EVENT, start);
+    pausesEmitted++;
+    return n;
+}
+
+uint32_t FitEncoder::getElapsedMs() const {
+    return (lastSecond - firstSecond) * 1000;
+}
+
+uint32_t FitEncoder::getTimerMs() const {
+    return emitted > pauses ? (emitted - 1 - pauses) * 1000 : 0;  // 1 s per step ridden, pauses left out
+}
+
+// ✅ Lap and session carry the same totals over the whole ride; `lap` picks the layout
+size_t FitEncoder::writeSummary(uint8_t *out, bool lap) const {
+    uint32_t end = timestamp(lastSecond);
+    uint32_t start = timestamp(firstSecond);
+    uint32_t calories = (uint32_t)(energy / 1000.0f * KCAL_PER_KJ + 0.5f);
+    uint32_t avgPower = average(powerSum, emitted);
+    uint32_t avgSpeed = average(speedSum, emitted);
+    uint32_t avgHeartRate = average(heartRateSum, heartRateCount);
+    uint32_t avgCadence = average(cadenceSum, cadenceCount);
+    uint32_t heartRateMax = maxHeartRate ? maxHeartRate : FIT_INVALID;
+
+    if (lap) {
+        uint32_t values[] = {
+            end, start, getElapsedMs(), getTimerMs(), distance * 100, calories, avgSpeed, maxSpeed, avgPower,
+            maxPower, avgHeartRate, heartRateMax, avgCadence, maxCadence, FIT_EVENT_LAP, FIT_EVENT_TYPE_STOP,
+            FIT_SPORT_CYCLING,
+        };
+        static_assert(sizeof(values) / sizeof(values[0]) == sizeof(LAP_FIELDS) / sizeof(LAP_FIELDS[0]), "lap");
+        return writeMessage(out, LAP, values);
+    }
+    uint32_t values[] = {
+        end, start, getElapsedMs(), getTimerMs(), distance * 100, calories, avgSpeed, maxSpeed, avgPower,
+        maxPower, 0, 1, avgHeartRate, heartRateMax, avgCadence, maxCadence, FIT_EVENT_SESSION, FIT_EVENT_TYPE_STOP,
+        FIT_SPORT_CYCLING, FIT_SUB_SPORT_INDOOR_CYCLING,
+    };
+    static_assert(sizeof(values) / sizeof(values[0]) == sizeof(SESSION_FIELDS) / sizeof(SESSION_FIELDS[0]),
+                  "session");
+    return writeMessage(out, SESSION, values);
+}
@@ -0,0 +1,93 @@
+#ifndef FIT_EXPORT_H
+#define FIT_EXPORT_H
+
+#include <Arduino.h>
+#include "ride_format.h"
+
+// ✅ Ride file (ride_format.h) → Garmin FIT activity, streamed. read() fills whatever
+// buffer the caller has, an HTTP chunk on the device, with the next bytes of the FIT
+// file, decoding the ride one block at a time: a ride of any length converts in the
+// encoder's own ~600 bytes.
+//
+// The FIT header holds the size of the data that follows, so begin() takes the ride's
+// RideSummary (sample and pause counts, clock) rather than reading the ride twice. A
+// ride still being recorded only grows, so the records stop at the summary's count.
+// One that comes up short (a block skipped for its CRC) repeats its last record up to
+// the count, so the file is always the size its header declares.
+//
+// Messages: file_id | timer start event | record per second (power, cadence, speed,
+// heart rate, distance, accumulated power), timer stop/start around pauses | timer stop
+// event | lap | session (indoor cycling) | activity. Timestamps are UTC once SNTP set
+// the clock during the ride; otherwise seconds since the ride started, which FIT reads
+// as relative time (below 0x10000000).
+
+#define FIT_HEADER_BYTES 14
+#define FIT_CRC_BYTES 2
+#define FIT_PROTOCOL_VERSION 0x10   // 1.0: no developer fields or 64-bit types needed
+#define FIT_PROFILE_VERSION 2140    // 21.40
+#define FIT_EPOCH_UNIX 631065600    // 1989-12-31 00:00:00 UTC, FIT time 0
+#define FIT_MANUFACTURER_DEVELOPMENT 255
+#define FIT_PRODUCT_ID 1
+#define FIT_STAGE_BYTES 128         // Largest run of messages staged at once (session: 107 bytes)
+
+class FitEncoder {
+public:
+    FitEncoder();
+    // From the file's start; false if it isn't a ride file or the summary has no samples
+    bool begin(RideReader::ReadFn read, void *context, const RideSummary &summary);
+    size_t read(uint8_t *out, size_t len);  // Next bytes of the FIT file; 0 at the end
+
+    uint32_t getSamples() const { return samples; }
+    uint32_t getPaddedRecords() const { return padded; }  // Repeats standing in for unreadable samples
+    uint32_t getFileBytes() const { return FIT_HEADER_BYTES + dataBytes + FIT_CRC_BYTES; }
+
+private:
+    enum class Stage : uint8_t { Header, Start, Records, Lap, Session, Activity, Crc, Done };
+
+    bool stageNext();
+    void stageRecord(const RideSample &sample);
+    size_t writePause(uint8_t *out, uint32_t stopped, uint32_t resumed);
+    size_t writeSummary(uint8_t *out, bool lap) const;
+    uint32_t getElapsedMs() const;
+    uint32_t getTimerMs() const;
+    uint32_t timestamp(uint32_t second) const { return timeOffset + second; }
+
+    RideReader reader;
+    Stage stage;
+    uint8_t staged[FIT_STAGE_BYTES];
+    size_t stagedLen;
+    size_t stagedPos;
+    uint16_t crc;
+
+    // From the summary
+    uint32_t samples;
+    uint32_t pauses;
+    uint32_t timeOffset;  // FIT time of ride second 0, or 0 for relative time
+    uint32_t dataBytes;
+
+    // Encoding pass
+    uint32_t emitted;
+    uint32_t padded;
+    uint32_t pausesEmitted;
+    uint32_t lastRecord[7];  // Fields of the last record message, for padding
+    uint32_t firstSecond;
+    uint32_t lastSecond;
+    uint32_t lastDistance;  // As recorded: a new BLE session restarts the totals...
+    uint32_t lastEnergy;
+    uint32_t distanceBase;  // ...so these carry the earlier sessions' part
+    uint32_t energyBase;
+    uint32_t distance;
+    uint32_t energy;
+    uint64_t powerSum;
+    uint64_t speedSum;
+    uint32_t cadenceSum;
+    uint32_t cadenceCount;
+    uint32_t heartRateSum;
+    uint32_t heartRateCount;
+    uint16_t maxPower;
+    uint16_t maxSpeed;
+    uint8_t maxCadence;
+    uint8_t maxHeartRate;
+};
+
+#endif  // FIT_EXPORT_H
@@ -0,0 +1,207 @@
+#include "ftms_control_point.h"
+#include "ant_uplink.h"
+#include "logger.h"
+
+// ANT+ FE-C control pages (trainer → receives, we → send)
+#define FEC_PAGE_BASIC_RESISTANCE 0x30  // Page 48
+#define FEC_PAGE_TARGET_POWER 0x31      // Page 49
+#define FEC_PAGE_WIND_RESISTANCE 0x32   // Page 50
+#define FEC_PAGE_TRACK_RESISTANCE 0x33  // Page 51
+#define FEC_RESERVED 0xFF
+
+#define FEC_DEFAULT_DRAFTING_FACTOR 100  // 1.00, i.e. no drafting
+
+// Fitness Machine Status (0x2ADA) op codes
+#define FTMS_STATUS_RESET 0x01
+#define FTMS_STATUS_STOPPED_OR_PAUSED 0x02
+#define FTMS_STATUS_STARTED_OR_RESUMED 0x04
+#define FTMS_STATUS_TARGET_RESISTANCE_CHANGED 0x07
+#define FTMS_STATUS_TARGET_POWER_CHANGED 0x08
+#define FTMS_STATUS_SIMULATION_CHANGED 0x12
+
+static inline int16_t readInt16(const uint8_t *p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint8_t clampByte(int32_t value) {
+    return value < 0 ? 0 : (value > 0xFE ? 0xFE : (uint8_t)value);  // 0xFF means "invalid" in FE-C
+}
+
+static bool sendTrainerPage(uint8_t pageNumber, uint8_t b5, uint8_t b6, uint8_t b7) {
+    uint8_t page[ANT_UPLINK_PAGE_LENGTH] = {
+        pageNumber, FEC_RESERVED, FEC_RESERVED, FEC_RESERVED, FEC_RESERVED, b5, b6, b7
+    };
+    return antUplink.sendPage(DeviceType::FitnessEquipment, page);
+}
+
+FTMSControlPoint::FTMSControlPoint() : controlPointChar(nullptr), statusChar(nullptr),
+                                       controller(FTMS_NO_CONTROLLER), targetActive(false) {
+    stats.commands = 0;
+    stats.rejected = 0;
+    stats.overBudget = 0;
+}
+
+void FTMSControlPoint::attach(NimBLECharacteristic *controlPoint, NimBLECharacteristic *status) {
+    controlPointChar = controlPoint;
+    statusChar = status;
+}
+
+void FTMSControlPoint::handleWrite(const uint8_t *data, size_t len, uint32_t receivedUs, uint16_t connHandle) {
+    if (len < 1) return;
+
+    uint8_t opCode = data[0];
+    uint8_t result = execute(opCode, data + 1, len - 1, connHandle);
+
+    // ✅ Latency stops once the FE-C page is in the UART TX buffer, before the response
+    uint32_t elapsedUs = micros() - receivedUs;
+    stats.writeToUplink.record(elapsedUs);
+    stats.commands++;
+    if (result != FTMS_RESULT_SUCCESS) stats.rejected++;
+    if (elapsedUs > FTMS_CONTROL_LATENCY_BUDGET_US) {
+        stats.overBudget++;
+        LOGF("[WARN] FTMS control op 0x%02X took %u us", opCode, elapsedUs);
+    }
+
+    respond(opCode, result, connHandle);
+}
+
+uint8_t FTMSControlPoint::execute(uint8_t opCode, const uint8_t *param, size_t paramLen, uint16_t connHandle) {
+    if (opCode == FTMS_OP_REQUEST_CONTROL) {
+        if (controller != FTMS_NO_CONTROLLER && controller != connHandle) return FTMS_RESULT_NOT_PERMITTED;
+        controller = connHandle;
+        LOGF("[INFO] FTMS control granted to connection %d", connHandle);
+        return FTMS_RESULT_SUCCESS;
+    }
+
+    if (controller != connHandle) return FTMS_RESULT_NOT_PERMITTED;
+
+    switch (opCode) {
+        case FTMS_OP_RESET: {
+            // ✅ Back to no target; the client must request control again
+            if (targetActive && !sendTrainerPage(FEC_PAGE_BASIC_RESISTANCE, FEC_RESERVED, FEC_RESERVED, 0)) {
+                return FTMS_RESULT_FAILED;
+            }
+            targetActive = false;
+            controller = FTMS_NO_CONTROLLER;
+            uint8_t status[] = { FTMS_STATUS_RESET };
+            notifyStatus(status, sizeof(status));
+            return FTMS_RESULT_SUCCESS;
+        }
+
+        case FTMS_OP_SET_TARGET_RESISTANCE:
+            return setTargetResistance(param, paramLen);
+
+        case FTMS_OP_SET_TARGET_POWER:
+            return setTargetPower(param, paramLen);
+
+        case FTMS_OP_START_RESUME: {
+            // FE-C has no start command; the trainer follows the rider. Acknowledge only.
+            uint8_t status[] = { FTMS_STATUS_STARTED_OR_RESUMED };
+            notifyStatus(status, sizeof(status));
+            return FTMS_RESULT_SUCCESS;
+        }
+
+        case FTMS_OP_STOP_PAUSE: {
+            if (paramLen < 1 || param[0] < 1 || param[0] > 2) return FTMS_RESULT_INVALID_PARAMETER;
+            uint8_t status[] = { FTMS_STATUS_STOPPED_OR_PAUSED, param[0] };
+            notifyStatus(status, sizeof(status));
+            return FTMS_RESULT_SUCCESS;
+        }
+
+        case FTMS_OP_SET_SIMULATION:
+            return setSimulation(param, paramLen);
+
+        default:
+            return FTMS_RESULT_NOT_SUPPORTED;
+    }
+}
+
+// ✅ ERG mode: FE-C page 49, target power in 0.25 W
+uint8_t FTMSControlPoint::setTargetPower(const uint8_t *param, size_t paramLen) {
+    if (paramLen < 2) return FTMS_RESULT_INVALID_PARAMETER;
+    int16_t watts = readInt16(param);
+    if (watts < 0 || watts > FTMS_MAX_TARGET_POWER) return FTMS_RESULT_INVALID_PARAMETER;
+
+    uint16_t quarterWatts = (uint16_t)(watts * 4);
+    if (!sendTrainerPage(FEC_PAGE_TARGET_POWER, FEC_RESERVED, quarterWatts & 0xFF, quarterWatts >> 8)) {
+        return FTMS_RESULT_FAILED;
+    }
+    targetActive = true;
+
+    uint8_t status[] = { FTMS_STATUS_TARGET_POWER_CHANGED, param[0], param[1] };
+    notifyStatus(status, sizeof(status));
+    return FTMS_RESULT_SUCCESS;
+}
+
+// ✅ FE-C page 48, total resistance in 0.5 %. FTMS v1.0 sends a uint8 level, later
+// revisions a sint16; both in 0.1 units, mapped 100.0 → 100 %.
+uint8_t FTMSControlPoint::setTargetResistance(const uint8_t *param, size_t paramLen) {
+    if (paramLen < 1) return FTMS_RESULT_INVALID_PARAMETER;
+    int16_t level = paramLen >= 2 ? readInt16(param) : param[0];
+    if (level < 0 || level > FTMS_MAX_RESISTANCE_LEVEL) return FTMS_RESULT_INVALID_PARAMETER;
+
+    uint8_t halfPercent = (uint8_t)(level / 5);
+    if (!sendTrainerPage(FEC_PAGE_BASIC_RESISTANCE, FEC_RESERVED, FEC_RESERVED, halfPercent)) {
+        return FTMS_RESULT_FAILED;
+    }
+    targetActive = true;
+
+    // Echo the level in the width the client used
+    uint8_t status[3] = { FTMS_STATUS_TARGET_RESISTANCE_CHANGED, param[0], paramLen >= 2 ? param[1] : (uint8_t)0 };
+    notifyStatus(status, paramLen >= 2 ? 3 : 2);
+    return FTMS_RESULT_SUCCESS;
+}
+
+// ✅ Simulation mode: grade and rolling resistance go in FE-C page 51 (sent first, it's
+// what the rider feels), wind speed and drag in page 50.
+uint8_t FTMSControlPoint::setSimulation(const uint8_t *param, size_t paramLen) {
+    if (paramLen < 6) return FTMS_RESULT_INVALID_PARAMETER;
+    int16_t windSpeed = readInt16(param);      // 0.001 m/s
+    int16_t grade = readInt16(param + 2);      // 0.01 %
+    uint8_t crr = param[4];                    // 0.0001
+    uint8_t windCoefficient = param[5];        // 0.01 kg/m, same unit in FE-C
+
+    uint16_t feGrade = (uint16_t)(grade + 20000);  // 0.01 %, offset -200.00 %
+    uint8_t feCrr = clampByte(crr * 2);            // 5e-5 units
+    int32_t windKmh = (windSpeed * 36 + (windSpeed >= 0 ? 5000 : -5000)) / 10000;  // Rounded
+    uint8_t feWind = clampByte(windKmh + 127);     // km/h, offset -127
+
+    if (!sendTrainerPage(FEC_PAGE_TRACK_RESISTANCE, feGrade & 0xFF, feGrade >> 8, feCrr) ||
+        !sendTrainerPage(FEC_PAGE_WIND_RESISTANCE, windCoefficient, feWind, FEC_DEFAULT_DRAFTING_FACTOR)) {
+        return FTMS_RESULT_FAILED;
+    }
+    targetActive = true;
+
+    uint8_t status[7] = { FTMS_STATUS_SIMULATION_CHANGED };
+    memcpy(status + 1, param, 6);
+    notifyStatus(status, sizeof(status));
+    return FTMS_RESULT_SUCCESS;
+}
+
+void FTMSControlPoint::releaseControl(uint16_t connHandle) {
+    if (connHandle != controller) return;  // Another client still has control
+    if (targetActive) {
+        sendTrainerPage(FEC_PAGE_BASIC_RESISTANCE, FEC_RESERVED, FEC_RESERVED, 0);
+        LOG("[INFO] FTMS control released, trainer back to no load");
+    }
+    targetActive = false;
+    controller = FTMS_NO_CONTROLLER;
+}
+
+void FTMSControlPoint::respond(uint8_t opCode, uint8_t result, uint16_t connHandle) {
+    if (!controlPointChar) return;
+    uint8_t response[3] = { FTMS_OP_RESPONSE, opCode, result };
+    controlPointChar->indicate(response, sizeof(response), connHandle);  // Only the writer gets the response
+}
+
+void FTMSControlPoint::notifyStatus(const uint8_t *status, size_t len) {
+    if (!statusChar) return;
+    statusChar->notify(status, len);
+}
+
+void FTMSControlPoint::logStats() const {
+    LOGF("[CTRL] commands: %u, rejected: %u, write→uplink p50/p99/max: %u/%u/%u us, over %u us: %u",
+         stats.commands, stats.rejected, stats.writeToUplink.percentile(50),
+         stats.writeToUplink.percentile(99), stats.writeToUplink.maxUs,
+         FTMS_CONTROL_LATENCY_BUDGET_US, stats.overBudget);
+}
@@ -0,0 +1,73 @@
+#ifndef FTMS_CONTROL_POINT_H
+#define FTMS_CONTROL_POINT_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include "latency_histogram.h"
+
+// FTMS Control Point (0x2AD9) op codes
+#define FTMS_OP_REQUEST_CONTROL 0x00
+#define FTMS_OP_RESET 0x01
+#define FTMS_OP_SET_TARGET_RESISTANCE 0x04
+#define FTMS_OP_SET_TARGET_POWER 0x05
+#define FTMS_OP_START_RESUME 0x07
+#define FTMS_OP_STOP_PAUSE 0x08
+#define FTMS_OP_SET_SIMULATION 0x11
+#define FTMS_OP_RESPONSE 0x80
+
+// Result codes in the 0x80 response indication
+#define FTMS_RESULT_SUCCESS 0x01
+#define FTMS_RESULT_NOT_SUPPORTED 0x02
+#define FTMS_RESULT_INVALID_PARAMETER 0x03
+#define FTMS_RESULT_FAILED 0x04
+#define FTMS_RESULT_NOT_PERMITTED 0x05
+
+// Advertised in Supported Power Range (0x2AD8) / Supported Resistance Level Range (0x2AD6)
+#define FTMS_MAX_TARGET_POWER 2000       // W
+#define FTMS_MAX_RESISTANCE_LEVEL 1000   // 0.1 units; level 100.0 = 100% FE-C resistance
+
+#define FTMS_CONTROL_LATENCY_BUDGET_US 50000  // Control point write → FE-C page on the UART
+#define FTMS_NO_CONTROLLER 0xFFFF  // No connection holds control
+
+struct FTMSControlStats {
+    uint32_t commands;
+    uint32_t rejected;      // Any response other than success
+    uint32_t overBudget;    // Commands slower than FTMS_CONTROL_LATENCY_BUDGET_US
+    LatencyHistogram writeToUplink;  // µs from the BLE write callback to the FE-C page written upstream
+};
+
+// ✅ Turns FTMS Control Point writes (ERG target power, simulation grade/wind,
+// resistance, start/stop) into ANT+ FE-C control pages sent straight to the Pi from
+// the BLE host task, then answers with the 0x80 response indication and the matching
+// Fitness Machine Status notify. Nothing is queued: the FE-C page is on the UART
+// before the client gets its response. With several centrals connected, one of them
+// holds control at a time; the others get "control not permitted" until it lets go.
+class FTMSControlPoint {
+public:
+    FTMSControlPoint();
+    void attach(NimBLECharacteristic *controlPoint, NimBLECharacteristic *status);
+    void handleWrite(const uint8_t *data, size_t len, uint32_t receivedUs, uint16_t connHandle);
+    void releaseControl(uint16_t connHandle);  // ✅ Client gone: if it had control, return the trainer to no load
+
+    bool isAttached() const { return controlPointChar != nullptr; }
+    bool hasControl() const { return controller != FTMS_NO_CONTROLLER; }
+    uint16_t getController() const { return controller; }
+    const FTMSControlStats &getStats() const { return stats; }
+    void logStats() const;
+
+private:
+    uint8_t execute(uint8_t opCode, const uint8_t *param, size_t paramLen, uint16_t connHandle);
+    uint8_t setTargetPower(const uint8_t *param, size_t paramLen);
+    uint8_t setTargetResistance(const uint8_t *param, size_t paramLen);
+    uint8_t setSimulation(const uint8_t *param, size_t paramLen);
+    void respond(uint8_t opCode, uint8_t result, uint16_t connHandle);
+    void notifyStatus(const uint8_t *status, size_t len);
+
+    NimBLECharacteristic *controlPointChar;
+    NimBLECharacteristic *statusChar;
+    volatile uint16_t controller;  // Connection that was granted control
+    bool targetActive;  // A target page was sent since control was granted
+    FTMSControlStats stats;
+};
+
+#endif  // FTMS_CONTROL_POINT_H
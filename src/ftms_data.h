@@ -0,0 +1,57 @@
+#ifndef FTMS_DATA_H
+#define FTMS_DATA_H
+
+#include <Arduino.h>
+
+enum class DeviceType {
+    Unknown = 0,
+    PowerMeter = 11,
+    FitnessEquipment = 17,
+    HeartRate = 120,
+    StrideSpeed = 124,
+    BikeCadence = 122,
+    BikeSpeed = 123,
+    CombinedSpeedCadence = 121
+};
+
+// ✅ Struct to store persistent FTMS data
+struct FTMSDataStorage {
+    uint32_t elapsed_time;  // Session totals (session_totals.h): seconds, meters, joules
+    uint32_t distance;
+    uint32_t energy_joules;
+    float speed;
+    uint8_t heart_rate;
+    uint16_t power;
+    uint8_t virtual_speed; 
+    uint16_t accumulated_power;
+    uint16_t instantaneous_power;
+    uint8_t cadence;
+    float cycle_length;
+    float incline;
+    float resistance;
+    uint8_t fe_state;
+    uint16_t manufacturerID;
+    uint32_t serialNumber;
+    uint16_t softwareVersion;
+    uint16_t modelNumber;
+    uint8_t hardware_revision; 
+    uint8_t trainer_status;
+    uint16_t maxResistance;
+    uint8_t batteryStatus;
+    uint8_t pedal_power_percent;
+    bool is_right_pedal;
+    uint32_t power_event_total;        // Rollover-extended event count of the fused power source
+    uint32_t power_accumulated_total;  // Rollover-extended accumulated power (W) of the same source
+    DeviceType power_source;           // Which sensor the two totals above come from
+    bool hasData;
+
+    FTMSDataStorage() : elapsed_time(0), distance(0), energy_joules(0), speed(0), heart_rate(0), power(0),
+                        virtual_speed(0), accumulated_power(0), instantaneous_power(0), cadence(0),
+                        cycle_length(0), incline(0), resistance(0), fe_state(0), manufacturerID(0),
+                        serialNumber(0), softwareVersion(0), modelNumber(0), hardware_revision(0),
+                        trainer_status(0), maxResistance(0), batteryStatus(255), pedal_power_percent(0),
+                        is_right_pedal(false), power_event_total(0), power_accumulated_total(0),
+                        power_source(DeviceType::Unknown), hasData(false) {}
+};
+
+#endif  // FTMS_DATA_H
@@ -0,0 +1,47 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <Arduino.h>
+
+#define LATENCY_BUCKETS 22  // Bucket i holds values in [2^(i-1), 2^i) µs; the last one is open-ended
+
+// ✅ Fixed log2-bucket histogram of microsecond latencies. record() is a few
+// instructions with no allocation, so it can sit on the data path.
+struct LatencyHistogram {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t maxUs;
+
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        memset(buckets, 0, sizeof(buckets));
+        count = 0;
+        maxUs = 0;
+    }
+
+    void record(uint32_t us) {
+        // ✅ Bucket = bit length of us (0 → 0, 1 → 1, 2-3 → 2, ...), one CLZ instruction
+        uint8_t bucket = us ? 32 - __builtin_clz(us) : 0;
+        if (bucket > LATENCY_BUCKETS - 1) bucket = LATENCY_BUCKETS - 1;
+        buckets[bucket]++;
+        count++;
+        if (us > maxUs) maxUs = us;
+    }
+
+    // Upper bound (µs) of the bucket holding the given percentile (0-100)
+    uint32_t percentile(uint8_t pct) const {
+        if (count == 0) return 0;
+        uint32_t target = (uint32_t)(((uint64_t)count * pct + 99) / 100);
+        uint32_t seen = 0;
+        for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= target) {
+                return (i == LATENCY_BUCKETS - 1) ? maxUs : (1UL << i);
+            }
+        }
+        return maxUs;
+    }
+};
+
+#endif  // LATENCY_HISTOGRAM_H
@@ -12,5 +12,6 @@ void led_init();
 void led_set_solid(int duration_ms);
 void led_set_flashing(int interval_ms);
 void led_turn_off();
+void led_update();  // ✅ Ends a timed solid LED; call from loop()
 
 #endif
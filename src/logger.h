@@ -3,12 +3,33 @@
 
 #include <Arduino.h>
 #include <stdarg.h>
+#include "deferred_log.h"
 
 // ✅ Define logger instance
 #ifdef DEBUG
-    #define logger Serial1
-    #define LOG(x) logger.println(x)
-    #define LOGF(x, ...) logger.printf(x, ##__VA_ARGS__), logger.println()
+    #define logger Serial1  // Raw debug port: begin(), the reboot console, and the log drain
+
+    // Messages above LOG_LEVEL compile away. The level comes from the message prefix:
+    // "[ERROR]", "[WARN]", "[DEBUG]"; anything else is INFO. -D LOG_LEVEL=3 drops DEBUG.
+    #ifndef LOG_LEVEL
+        #define LOG_LEVEL LOG_LEVEL_DEBUG
+    #endif
+
+    // ✅ Deferred: the caller only stores the format id and raw arguments in a ring;
+    // the log_drain task formats and prints them (see deferred_log.h)
+    #define LOG(x) do { \
+        if (logLevelOf(x) <= LOG_LEVEL) logDeferredText(logLevelOf(x), x); \
+    } while (0)
+    // Never called, only named in sizeof: the compiler checks each LOGF format against
+    // its arguments as it would for printf
+    inline void logCheckFormat(const char *, ...) __attribute__((format(printf, 1, 2)));
+    inline void logCheckFormat(const char *, ...) {}
+
+    #define LOGF(x, ...) do { \
+        (void)sizeof((logCheckFormat(x, ##__VA_ARGS__), 0)); \
+        constexpr uint8_t logLevel_ = logLevelOf(x); \
+        if constexpr (logLevel_ <= LOG_LEVEL) logDeferred(logLevel_, x, ##__VA_ARGS__); \
+    } while (0)
 #else
     class NullLogger {
     public:
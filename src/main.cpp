@@ -3,45 +3,57 @@
 #include "ble_ftms.h"
 #include "logger.h"
 #include "esp_system.h"
-#include "esp_timer.h"  // ✅ ESP32 Software Timer API
 #include "wifi_manager.h"
 #include "websocket_manager.h"
 #include "led_service.h"
+#include "serial_ingest.h"
+#include "pipeline.h"
+#include "ant_uplink.h"
+#include "metrics.h"
+#include "task_profiler.h"
+#include "telemetry_stream.h"
+#include "capture_recorder.h"
+#include "ride_recorder.h"
 
-#define SERIAL_BAUDRATE 115200
-#define FTMS_UPDATE_INTERVAL_US (2000000)  // 2 seconds in microseconds
+#define LOG_BAUDRATE 115200
+#define PIPELINE_STATS_INTERVAL_MS 10000
+#define METRICS_PUBLISH_INTERVAL_MS 5000  // JSON snapshot to WebSocket clients
+#define METRICS_SEND_TIMEOUT_MS 50  // Per frame of the METRICS answer
+#define LINK_ANSWER_TIMEOUT_MS 50
 
 void checkForReboot();  // Function declaration
-void sendFTMSUpdate(void* arg);  // Timer callback function
 void onBLEConnect();  // Function to start sending data
 void onBLEDisconnect();  // Function to stop sending data
+bool handleSerialCommand(const String &command);  // 0xF0 commands not handled by ANTParser
+void sendMetricsSnapshot();  // Answer to the METRICS command, from loop()
+void announceLinkVersion();  // Answer to LINK V1/V2, and news of a v2 → v1 fallback
+
+static volatile bool metricsRequested = false;  // Set by the parse task, served by loop()
+static volatile bool linkAnswerRequested = false;
+static volatile uint32_t lastClientLeftMs = 0;  // millis() the last BLE client left; 0 while one is connected
 
 ANTParser antParser;
 BLEFTMS bleFTMS;
-esp_timer_handle_t ftmsTimer;  // ✅ ESP32 Timer Handle
-bool isBLEConnected = false;   // ✅ Track BLE connection status
 
 void setup() {
-    Serial.begin(SERIAL_BAUDRATE);  // ANT+ Data Input (Raspberry Pi -> ESP32)
-    logger.begin(SERIAL_BAUDRATE, SERIAL_8N1, 9, 10);  // Debug Output via GPIO9/10
+    metrics.markBoot(BOOT_SETUP);
+    serialIngest.begin(Serial, SERIAL_BAUDRATE);  // ANT+ Data Input (Raspberry Pi -> ESP32)
+    antUplink.begin(Serial);  // FE-C control pages back to the Pi (ESP32 -> Raspberry Pi)
+    logger.begin(LOG_BAUDRATE, SERIAL_8N1, 9, 10);  // Debug Output via GPIO9/10
+    metrics.begin();
+#ifdef DEBUG
+    log_start(logger);  // ✅ LOG/LOGF only queue; this low-priority task prints
+#endif
 
     LOG("ESP32-S3 ANT+ to BLE FTMS");
 
-    wifi_init();  // ✅ Simple WiFi connection
-
-    // ✅ Ensure WiFi is connected before starting WebSockets
-    while (WiFi.status() != WL_CONNECTED) {
-        LOG("⏳ Waiting for WiFi...");
-        delay(1000);
-    }
-
-    LOG("🚀 Starting WebSocket Server...");
-    startWebSocketServer();
-    LOG("✅ WebSocket Server Started!");
-
-    // Initialize BLE FTMS
+    // ✅ BLE first: the trainer is usable before WiFi (if any) comes up
     bleFTMS.begin();
 
+    antParser.begin();
+    antParser.setCommandHandler(handleSerialCommand);
+    antParser.setFrameTap(capture_record);  // ✅ Flight recorder; flash writes on its own task
+
     // Register BLE Callbacks
     bleFTMS.setConnectCallback(onBLEConnect);
     bleFTMS.setDisconnectCallback(onBLEDisconnect);
@@ -49,67 +61,181 @@ void setup() {
     // Print unique ESP32-S3 MAC address
     LOG("Device BLE MAC: " + bleFTMS.getDeviceMAC());
 
-    // ✅ Set up FTMS update timer (but don't start it yet)
-    const esp_timer_create_args_t timerArgs = {
-        .callback = &sendFTMSUpdate,
-        .arg = nullptr,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "FTMS Update Timer"
-    };
-    esp_timer_create(&timerArgs, &ftmsTimer);
+    capture_start();  // Before the parse task, so the first frames are kept too
+
+    // ✅ UART RX → parse → BLE notify tasks; notifies start once a client connects
+    pipeline_set_sample_listener(telemetry_publish);  // ✅ Same samples, binary on /ws
+    pipeline_start(antParser, bleFTMS);
+    ride_start(antParser);  // ✅ 1 Hz workout file, whether or not an app is connected
+
+    // ✅ Never waits: loop() drives the connection and starts /ws once it is up
+    wifi_start();
 }
 
 void loop() {
-    static unsigned long lastReconnectAttempt = 0;  // Track last reconnect time
-    antParser.readSerial();
+    static bool webStarted = false;
+    static unsigned long lastStatsLog = 0;
+    static unsigned long lastMetricsPublish = 0;
     checkForReboot();  // Check if "reboot" command is received
 
-    // ✅ Restart advertising if it stops
-    if (!NimBLEDevice::getAdvertising()->isAdvertising()) {
+    // ✅ Restart advertising if it stops while there is room for another central
+    if (bleFTMS.getConnectedCount() < BLE_MAX_CONNECTIONS && !NimBLEDevice::getAdvertising()->isAdvertising()) {
         LOG("[WARN] BLE Advertising Stopped! Restarting...");
         NimBLEDevice::getAdvertising()->start(0);  // Restart indefinitely
     }
 
-    /*
-    // ✅ Improved WiFi reconnection logic
-    if (WiFi.status() != WL_CONNECTED) {
-        if (millis() - lastReconnectAttempt > 5000) {  // Retry every 5 seconds
-            lastReconnectAttempt = millis();
-            LOGF("⚠️ WiFi disconnected! Attempting reconnect at %lu ms", millis());
-            WiFi.reconnect();
+    // ✅ WiFi retries with backoff; the WebSocket server starts on the first connection
+    wifi_update(millis());
+    if (!webStarted && wifi_is_connected()) {
+        webStarted = true;
+        LOG("🚀 Starting WebSocket Server...");
+        startWebSocketServer();
+        telemetry_start();
+    }
+    led_update();
+
+    if (millis() - lastStatsLog > PIPELINE_STATS_INTERVAL_MS) {
+        lastStatsLog = millis();
+        pipeline_log_stats();
+        bleFTMS.getControlPoint().logStats();
+        bleFTMS.logConnectionStats(millis());
+        telemetry_log_stats();
+        capture_log_stats();
+        ride_log_stats();
+        if (antParser.getSerialLinkVersion() == SERIAL_LINK_V2) {
+            const SerialLinkV2Stats &link = antParser.getLinkV2Stats();
+            LOGF("[LINK] v2 packets: %u, messages: %u, crc errors: %u, format errors: %u, drops: %u, reorders: %u",
+                 link.packets, link.messages, link.crcErrors, link.formatErrors, link.drops, link.reorders);
         }
     }
-*/
-    delay(100);  // Reduce CPU usage instead of `sleep(0.1)`
-}
 
-// ✅ Timer Callback Function (Runs Every 2 Seconds When Connected)
-void sendFTMSUpdate(void* arg) {
-    if (!isBLEConnected) {
-        LOG("[DEBUG] No BLE connection, skipping FTMS update.");
-        return;
+    // ✅ A client back within SESSION_RESUME_MS picks up the ride where it left off
+    uint32_t leftMs = lastClientLeftMs;
+    if (leftMs && millis() - leftMs > SESSION_RESUME_MS) {
+        lastClientLeftMs = 0;
+        antParser.resetSession();
+        LOG("[INFO] No BLE client for a while: session totals reset");
+    }
+
+    if (metricsRequested) {
+        metricsRequested = false;
+        sendMetricsSnapshot();
+    }
+
+    announceLinkVersion();
+
+    if (millis() - lastMetricsPublish > METRICS_PUBLISH_INTERVAL_MS) {
+        lastMetricsPublish = millis();
+        publishMetricsSnapshot();
     }
 
-    FTMSDataStorage ftmsData = antParser.getFTMSData();
+    if (profiler_due(millis())) {
+        publishTaskProfile();
+    }
 
-    bleFTMS.sendIndoorBikeData(ftmsData);
-    LOGF("[DEBUG] BLE FTMS Update: Power=%dW, Speed=%d km/h, Cadence=%d rpm, Distance=%d m, Resistance=%.1f, Elapsed Time=%d s",
-        ftmsData.power, ftmsData.speed, ftmsData.cadence, ftmsData.distance, ftmsData.resistance, ftmsData.elapsed_time);
+    delay(100);  // Housekeeping only; ANT+ data is handled by the pipeline tasks
 }
 
 // ✅ BLE Connect Callback → Start Sending Data
 void onBLEConnect() {
     LOG("[INFO] BLE Device Connected! Starting FTMS updates.");
-    isBLEConnected = true;
-    esp_timer_start_periodic(ftmsTimer, FTMS_UPDATE_INTERVAL_US);  // ✅ Start Timer
+    lastClientLeftMs = 0;
+    pipeline_set_connected(true);
 }
 
-// ✅ BLE Disconnect Callback → Stop Sending Data
+// ✅ BLE Disconnect Callback → Stop Sending Data once the last central is gone
 void onBLEDisconnect() {
+    if (bleFTMS.getConnectedCount() > 0) {
+        LOGF("[INFO] BLE Device Disconnected! %d still connected, FTMS updates continue.",
+             bleFTMS.getConnectedCount());
+        return;
+    }
     LOG("[INFO] BLE Device Disconnected! Stopping FTMS updates.");
-    isBLEConnected = false;
-    esp_timer_stop(ftmsTimer);  // ✅ Stop Timer
-    antParser.resetFTMData();  // Reset FTMS data
+    pipeline_set_connected(false);
+    antParser.resetFTMData();  // Reset FTMS data; session totals wait for SESSION_RESUME_MS
+    lastClientLeftMs = millis() ? millis() : 1;
+}
+
+// ✅ Application-level serial commands (sent as 0xF0 frames from the Pi)
+//   NOTIFY <maxHz> <keepaliveMs>   Indoor Bike Data notify rate limit and keepalive
+//   LINK LOWLATENCY | LOWPOWER     BLE connection parameter profile
+//   LINK V1 | LINK V2              Serial framing (see serial_link_v2.h), answered with an 'L' frame
+//   METRICS                        Binary metrics snapshot back to the Pi (see metrics.h)
+//   METRICS RESET                  Zero all counters and histograms
+//   PROFILE <ms> | PROFILE OFF     Per-task CPU/stack snapshots on /ws
+//   CAPTURE ON | CAPTURE OFF       Flight recorder of ingested frames (see capture_recorder.h)
+bool handleSerialCommand(const String &command) {
+    unsigned int maxHz, keepaliveMs;
+    if (sscanf(command.c_str(), "NOTIFY %u %u", &maxHz, &keepaliveMs) == 2) {
+        bleFTMS.setNotifySchedule(maxHz > 0xFF ? 0 : maxHz, keepaliveMs > 0xFFFF ? 0 : keepaliveMs);
+        return true;
+    }
+    if (command == "LINK LOWLATENCY") {
+        return bleFTMS.getLinkManager().setProfile(LinkProfile::LowLatency);
+    }
+    if (command == "LINK LOWPOWER") {
+        return bleFTMS.getLinkManager().setProfile(LinkProfile::LowPower);
+    }
+    if (command == "LINK V1" || command == "LINK V2") {
+        if (!antParser.setSerialLinkVersion(command == "LINK V2" ? SERIAL_LINK_V2 : SERIAL_LINK_V1)) return false;
+        linkAnswerRequested = true;  // ✅ Answered from loop(), like METRICS
+        return true;
+    }
+    if (command == "METRICS") {
+        metricsRequested = true;  // ✅ Sending may wait for UART room; not on the parse task
+        return true;
+    }
+    if (command == "METRICS RESET") {
+        metrics.reset();
+        return true;
+    }
+    if (command == "CAPTURE ON" || command == "CAPTURE OFF") {
+        capture_set_enabled(command == "CAPTURE ON");
+        return true;
+    }
+    unsigned int profileMs;
+    if (command == "PROFILE OFF") {
+        return profiler_set_interval(0);
+    }
+    if (sscanf(command.c_str(), "PROFILE %u", &profileMs) == 1) {
+        return profiler_set_interval(profileMs);
+    }
+    return false;
+}
+
+// ✅ The binary snapshot split over 0xF0 frames: index | count | chunk
+void sendMetricsSnapshot() {
+    uint8_t snapshot[METRICS_BINARY_SIZE];
+    size_t len = metrics.writeBinary(snapshot, sizeof(snapshot), millis());
+    uint8_t count = (len + METRICS_CHUNK_BYTES - 1) / METRICS_CHUNK_BYTES;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t payload[METRICS_CHUNK_BYTES + 2];
+        size_t offset = i * METRICS_CHUNK_BYTES;
+        size_t chunk = len - offset < METRICS_CHUNK_BYTES ? len - offset : METRICS_CHUNK_BYTES;
+        payload[0] = i;
+        payload[1] = count;
+        memcpy(payload + 2, snapshot + offset, chunk);
+        if (!antUplink.sendCommand(METRICS_FRAME_TYPE, payload, chunk + 2, METRICS_SEND_TIMEOUT_MS)) {
+            LOG("[WARN] METRICS answer dropped: serial link busy");
+            return;
+        }
+    }
+}
+
+// ✅ 'L' frame with the serial link version in use, whenever the Pi asked or it changed
+void announceLinkVersion() {
+    static uint8_t announced = SERIAL_LINK_V1;
+    uint8_t version = antParser.getSerialLinkVersion();
+    if (!linkAnswerRequested && version == announced) return;
+
+    linkAnswerRequested = false;
+    if (antUplink.sendCommand(LINK_FRAME_TYPE, &version, 1, LINK_ANSWER_TIMEOUT_MS)) {
+        announced = version;
+    } else {
+        linkAnswerRequested = true;  // Serial link busy; try again next loop()
+        LOG("[WARN] LINK answer delayed: serial link busy");
+    }
 }
 
 // ✅ Function to Listen for "Reboot" Command
@@ -0,0 +1,130 @@
+#include "metrics.h"
+#include <stdarg.h>
+#include "logger.h"
+
+MetricsRegistry metrics;
+
+static const char *const COUNTER_NAMES[METRIC_COUNTER_COUNT] = {
+    "frames", "crc_failures",
+    "unknown_pages_fe", "unknown_pages_pm", "unknown_pages_hr", "unknown_pages_cadence",
+    "unknown_pages_speed", "unknown_pages_speed_cadence", "unknown_pages_other",
+    "notifies", "notify_failures", "link_drops", "link_reorders"
+};
+
+static const char *const HISTOGRAM_NAMES[METRIC_HISTOGRAM_COUNT] = {
+    "frame_interarrival_us", "parse_us", "notify_us"
+};
+
+static const char *const BOOT_STAGE_NAMES[BOOT_STAGE_COUNT] = {
+    "setup", "advertising", "first_connect", "first_notify", "wifi"
+};
+
+static inline uint8_t *putUInt32(uint8_t *p, uint32_t value) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = value >> 24;
+    return p + 4;
+}
+
+MetricsRegistry::MetricsRegistry() : cyclesPerUs(METRICS_DEFAULT_CPU_MHZ) {
+    reset();
+    for (uint8_t i = 0; i < BOOT_STAGE_COUNT; i++) bootUs[i].store(0, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::begin() {
+#ifndef NATIVE_BUILD
+    cyclesPerUs = ESP.getCpuFreqMHz();
+#endif
+}
+
+void MetricsRegistry::reset() {
+    for (uint8_t i = 0; i < METRIC_COUNTER_COUNT; i++) counters[i].store(0, std::memory_order_relaxed);
+    for (uint8_t i = 0; i < METRIC_HISTOGRAM_COUNT; i++) histograms[i].reset();
+}
+
+void MetricsRegistry::onBootStage(BootStage stage, uint32_t us) {
+    LOGF("[BOOT] %s after %u.%03u ms", BOOT_STAGE_NAMES[stage], us / 1000, us % 1000);
+}
+
+const char *MetricsRegistry::counterName(MetricCounter counter) {
+    return counter < METRIC_COUNTER_COUNT ? COUNTER_NAMES[counter] : "?";
+}
+
+const char *MetricsRegistry::histogramName(MetricHistogram histogram) {
+    return histogram < METRIC_HISTOGRAM_COUNT ? HISTOGRAM_NAMES[histogram] : "?";
+}
+
+// ✅ snprintf at `n`, never past `size`; `n` still counts what didn't fit. The attribute
+// keeps every call's format checked against its arguments.
+static void appendf(char *out, size_t size, size_t &n, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+static void appendf(char *out, size_t size, size_t &n, const char *format, ...) {
+    if (n >= size) return;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(out + n, size - n, format, args);
+    va_end(args);
+    if (written > 0) n += written;
+}
+
+// ✅ {"type":"metrics","uptime_ms":..,"counters":{"frames":..,...},"boot_us":{"setup":..,...},
+// "histograms":{"parse_us":{"count":..,"p50":..,"p99":..,"max":..,"buckets":[..]},...}};
+// bucket i is [2^(i-1), 2^i) µs
+size_t MetricsRegistry::writeJson(char *out, size_t size, uint32_t uptimeMs) const {
+    size_t n = 0;
+    appendf(out, size, n, "{\"type\":\"metrics\",\"uptime_ms\":%u,\"counters\":{", (unsigned)uptimeMs);
+    for (uint8_t i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        appendf(out, size, n, "%s\"%s\":%u", i ? "," : "", COUNTER_NAMES[i], (unsigned)get((MetricCounter)i));
+    }
+    appendf(out, size, n, "},\"boot_us\":{");
+    for (uint8_t i = 0; i < BOOT_STAGE_COUNT; i++) {
+        appendf(out, size, n, "%s\"%s\":%u", i ? "," : "", BOOT_STAGE_NAMES[i], (unsigned)getBootUs((BootStage)i));
+    }
+    appendf(out, size, n, "},\"histograms\":{");
+    for (uint8_t i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        const LatencyHistogram &h = histograms[i];
+        appendf(out, size, n, "%s\"%s\":{\"count\":%u,\"p50\":%u,\"p99\":%u,\"max\":%u,\"buckets\":[",
+               i ? "," : "", HISTOGRAM_NAMES[i], (unsigned)h.count, (unsigned)h.percentile(50),
+               (unsigned)h.percentile(99), (unsigned)h.maxUs);
+        for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) {
+            appendf(out, size, n, "%s%u", b ? "," : "", (unsigned)h.buckets[b]);
+        }
+        appendf(out, size, n, "]}");
+    }
+    appendf(out, size, n, "}}");
+
+    if (n >= size) {  // Truncated: never hand out half a document
+        if (size) out[0] = '\0';
+        return 0;
+    }
+    return n;
+}
+
+size_t MetricsRegistry::writeBinary(uint8_t *out, size_t size, uint32_t uptimeMs) const {
+    if (size < METRICS_BINARY_SIZE) return 0;
+
+    uint8_t *p = out;
+    *p++ = 'M';
+    *p++ = 'T';
+    *p++ = METRICS_BINARY_VERSION;
+    *p++ = METRIC_COUNTER_COUNT;
+    *p++ = METRIC_HISTOGRAM_COUNT;
+    *p++ = LATENCY_BUCKETS;
+    *p++ = BOOT_STAGE_COUNT;
+    p = putUInt32(p, uptimeMs);
+
+    for (uint8_t i = 0; i < METRIC_COUNTER_COUNT; i++) {
+        p = putUInt32(p, get((MetricCounter)i));
+    }
+    for (uint8_t i = 0; i < BOOT_STAGE_COUNT; i++) {
+        p = putUInt32(p, getBootUs((BootStage)i));
+    }
+    for (uint8_t i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+        const LatencyHistogram &h = histograms[i];
+        p = putUInt32(p, h.count);
+        p = putUInt32(p, h.maxUs);
+        for (uint8_t b = 0; b < LATENCY_BUCKETS; b++) p = putUInt32(p, h.buckets[b]);
+    }
+    return p - out;
+}
@@ -0,0 +1,139 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "ftms_data.h"
+#include "latency_histogram.h"
+
+enum MetricCounter : uint8_t {
+    METRIC_FRAMES_RECEIVED,
+    METRIC_CRC_FAILURES,
+    METRIC_UNKNOWN_PAGES_FE,  // Pages with no handler, per device type
+    METRIC_UNKNOWN_PAGES_PM,
+    METRIC_UNKNOWN_PAGES_HR,
+    METRIC_UNKNOWN_PAGES_CADENCE,
+    METRIC_UNKNOWN_PAGES_SPEED,
+    METRIC_UNKNOWN_PAGES_SPEED_CADENCE,
+    METRIC_UNKNOWN_PAGES_OTHER,  // Device types the parser has no routes for
+    METRIC_NOTIFIES_SENT,
+    METRIC_NOTIFY_FAILURES,
+    METRIC_LINK_DROPS,     // Serial link v2 packets missing from the sequence
+    METRIC_LINK_REORDERS,  // Serial link v2 packets that arrived late or twice
+    METRIC_COUNTER_COUNT
+};
+
+enum MetricHistogram : uint8_t {
+    METRIC_FRAME_INTERARRIVAL,  // µs between consecutive frames reaching the parser
+    METRIC_PARSE_TIME,          // µs to dispatch and parse one frame
+    METRIC_NOTIFY_LATENCY,      // µs the BLE stack takes to accept one notify
+    METRIC_HISTOGRAM_COUNT
+};
+
+// ✅ One-shot boot milestones, µs since the app started (0 = not reached yet). ROM and
+// second-stage bootloader time comes before that clock starts and isn't included.
+enum BootStage : uint8_t {
+    BOOT_SETUP,          // setup() entered
+    BOOT_ADVERTISING,    // First BLE advertisement on air
+    BOOT_FIRST_CONNECT,  // First central connected
+    BOOT_FIRST_NOTIFY,   // First notify accepted by the stack
+    BOOT_WIFI,           // First IP address
+    BOOT_STAGE_COUNT
+};
+
+// Binary snapshot: "MT" | version | counters | histograms | buckets | boot stages |
+// uptimeMs (u32), then every counter (u32), every boot stage (u32 µs), then per
+// histogram count, max and every bucket (u32). All little-endian.
+#define METRICS_BINARY_VERSION 2
+#define METRICS_BINARY_HEADER 11
+#define METRICS_BINARY_SIZE (METRICS_BINARY_HEADER + METRIC_COUNTER_COUNT * 4 + BOOT_STAGE_COUNT * 4 + \
+                             METRIC_HISTOGRAM_COUNT * (2 + LATENCY_BUCKETS) * 4)
+#define METRICS_JSON_SIZE 1792
+
+// Answer to the METRICS serial command: the binary snapshot in 0xF0 frames of type
+// 'M', each payload `index | count | up to METRICS_CHUNK_BYTES of the snapshot`
+#define METRICS_FRAME_TYPE 'M'
+#define METRICS_CHUNK_BYTES 30
+
+#ifndef METRICS_DEFAULT_CPU_MHZ
+    #ifdef CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+        #define METRICS_DEFAULT_CPU_MHZ CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+    #else
+        #define METRICS_DEFAULT_CPU_MHZ 240
+    #endif
+#endif
+
+constexpr MetricCounter unknownPagesCounter(DeviceType type) {
+    switch (type) {
+        case DeviceType::FitnessEquipment: return METRIC_UNKNOWN_PAGES_FE;
+        case DeviceType::PowerMeter: return METRIC_UNKNOWN_PAGES_PM;
+        case DeviceType::HeartRate: return METRIC_UNKNOWN_PAGES_HR;
+        case DeviceType::BikeCadence: return METRIC_UNKNOWN_PAGES_CADENCE;
+        case DeviceType::BikeSpeed: return METRIC_UNKNOWN_PAGES_SPEED;
+        case DeviceType::CombinedSpeedCadence: return METRIC_UNKNOWN_PAGES_SPEED_CADENCE;
+        default: return METRIC_UNKNOWN_PAGES_OTHER;
+    }
+}
+
+// ✅ Process-wide counters and histograms for production diagnostics. Counters are
+// relaxed atomics, safe to bump from any task. Each histogram has a single writer
+// (frame histograms: the parsing task, notify latency: the notify task); snapshots
+// read them without locking, so a dump may be off by the sample being recorded.
+class MetricsRegistry {
+public:
+    MetricsRegistry();
+    void begin();  // ✅ Picks up the CPU clock for span timing
+
+    // ✅ Span timing for histograms: the CPU cycle counter is one instruction, micros()
+    // goes through esp_timer. Only for short spans started and stopped on one task.
+    uint32_t spanStart() const {
+#ifdef NATIVE_BUILD
+        return micros();
+#else
+        return ESP.getCycleCount();
+#endif
+    }
+    uint32_t spanUs(uint32_t start) const {
+#ifdef NATIVE_BUILD
+        return micros() - start;
+#else
+        return (ESP.getCycleCount() - start) / cyclesPerUs;
+#endif
+    }
+
+    void increment(MetricCounter counter, uint32_t n = 1) {
+        counters[counter].fetch_add(n, std::memory_order_relaxed);
+    }
+    void record(MetricHistogram histogram, uint32_t us) { histograms[histogram].record(us); }
+    void markBoot(BootStage stage) {
+        if (bootUs[stage].load(std::memory_order_relaxed) != 0) return;  // First time only
+        uint32_t now = micros();
+        uint32_t unset = 0;
+        if (bootUs[stage].compare_exchange_strong(unset, now ? now : 1, std::memory_order_relaxed)) {
+            onBootStage(stage, now);
+        }
+    }
+
+    uint32_t get(MetricCounter counter) const { return counters[counter].load(std::memory_order_relaxed); }
+    const LatencyHistogram &getHistogram(MetricHistogram histogram) const { return histograms[histogram]; }
+    uint32_t getBootUs(BootStage stage) const { return bootUs[stage].load(std::memory_order_relaxed); }
+    void reset();  // Counters and histograms; boot milestones stay
+
+    size_t writeJson(char *out, size_t size, uint32_t uptimeMs) const;
+    size_t writeBinary(uint8_t *out, size_t size, uint32_t uptimeMs) const;  // 0 if `size` is too small
+
+    static const char *counterName(MetricCounter counter);
+    static const char *histogramName(MetricHistogram histogram);
+
+private:
+    void onBootStage(BootStage stage, uint32_t us);
+
+    std::atomic<uint32_t> counters[METRIC_COUNTER_COUNT];
+    LatencyHistogram histograms[METRIC_HISTOGRAM_COUNT];
+    std::atomic<uint32_t> bootUs[BOOT_STAGE_COUNT];
+    uint32_t cyclesPerUs;
+};
+
+extern MetricsRegistry metrics;
+
+#endif  // METRICS_H
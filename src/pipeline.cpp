@@ -0,0 +1,145 @@
+#include "pipeline.h"
+#include "serial_ingest.h"
+#include "websocket_ingest.h"
+#include "logger.h"
+
+static ANTParser *pipelineParser = nullptr;
+static BLEFTMS *pipelineFTMS = nullptr;
+static TaskHandle_t parseTaskHandle = nullptr;
+static TaskHandle_t notifyTaskHandle = nullptr;
+static QueueHandle_t notifyQueue = nullptr;
+static volatile bool bleConnected = false;
+static PipelineSampleListener sampleListener = nullptr;
+static PipelineStats stats;
+
+// ✅ Runs on the UART event task (SerialIngest) or the AsyncTCP task (WebSocketIngest)
+// right after new bytes were committed to its ring
+static void onIngestData() {
+    if (parseTaskHandle) xTaskNotifyGive(parseTaskHandle);
+}
+
+// Arrival time of the oldest bytes still waiting in either ring
+static uint32_t oldestPendingMicros() {
+    uint32_t oldest = micros();
+    if (serialIngest.getRing().size() > 0) oldest = serialIngest.getOldestPendingMicros();
+    if (wsIngest.getRing().size() > 0 && (int32_t)(wsIngest.getOldestPendingMicros() - oldest) < 0) {
+        oldest = wsIngest.getOldestPendingMicros();
+    }
+    return oldest;
+}
+
+static void parseTask(void *arg) {
+    for (;;) {
+        bool woken = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(PIPELINE_REFRESH_MS)) > 0;
+
+        uint32_t rxUs = oldestPendingMicros();
+        if (woken) {
+            pipelineParser->readSerial();
+            pipelineParser->readWebSocket();
+        } else {
+            pipelineParser->refresh();  // ✅ No frames for a while: let silent sensors go stale
+            rxUs = micros();
+        }
+        if (!pipelineParser->hasNewData()) continue;
+
+        PipelineEvent event = { rxUs, (uint32_t)micros() };
+        if (woken) stats.rxToParse.record(event.parsedUs - event.rxUs);
+
+        if (xQueueSend(notifyQueue, &event, 0) != pdTRUE) {
+            stats.queueDrops++;
+        }
+    }
+}
+
+static uint16_t ageMs(uint32_t nowUs, uint32_t rxUs) {
+    uint32_t ms = (nowUs - rxUs) / 1000;
+    return ms >= PIPELINE_NO_AGE ? PIPELINE_NO_AGE - 1 : ms;
+}
+
+static void notifyTask(void *arg) {
+    PipelineEvent pending;
+    bool havePending = false;
+    uint32_t lastSampleMs = 0;
+
+    for (;;) {
+        // ✅ Sleep until a sample arrives, the rate window reopens, or the keepalive is due
+        uint32_t waitMs = bleConnected ? pipelineFTMS->getNotifyWaitMs(millis()) : FTMS_DEFAULT_KEEPALIVE_MS;
+        PipelineEvent event;
+        bool fresh = xQueueReceive(notifyQueue, &event, pdMS_TO_TICKS(waitMs)) == pdTRUE;
+
+        // ✅ Coalesce a backlog into one notify; latency is measured from the oldest event
+        if (fresh) {
+            if (!havePending) pending = event;
+            havePending = true;
+            while (xQueueReceive(notifyQueue, &event, 0) == pdTRUE) {}
+        }
+
+        if (!bleConnected) {
+            // ✅ No central: listeners still get fresh samples, at most at the notify rate
+            uint32_t nowMs = millis();
+            if (havePending && sampleListener && nowMs - lastSampleMs >= pipelineFTMS->getNotifyIntervalMs()) {
+                sampleListener(pipelineParser->getFTMSData(), nowMs, ageMs(micros(), pending.rxUs));
+                lastSampleMs = nowMs;
+            }
+            havePending = false;
+            continue;
+        }
+
+        FTMSDataStorage data = pipelineParser->getFTMSData();
+        uint32_t nowMs = millis();
+        pipelineFTMS->setWheelCircumference(pipelineParser->getWheelCircumference());  // ✅ Follows WHEEL <mm>
+        NotifyResult result = pipelineFTMS->updateMeasurements(data, fresh, nowMs);
+        if (result == NotifyResult::Sent && havePending) {
+            uint32_t now = micros();
+            stats.parseToNotify.record(now - pending.parsedUs);
+            stats.rxToNotify.record(now - pending.rxUs);
+            stats.notifies++;
+            havePending = false;
+            if (sampleListener) sampleListener(data, nowMs, ageMs(now, pending.rxUs));
+        } else if (result == NotifyResult::Sent) {
+            stats.keepalives++;
+            if (sampleListener) sampleListener(data, nowMs, PIPELINE_NO_AGE);
+        } else if (result == NotifyResult::Unchanged) {
+            havePending = false;
+        }
+    }
+}
+
+void pipeline_start(ANTParser &parser, BLEFTMS &ftms) {
+    pipelineParser = &parser;
+    pipelineFTMS = &ftms;
+
+    notifyQueue = xQueueCreate(PIPELINE_QUEUE_LENGTH, sizeof(PipelineEvent));
+
+    xTaskCreatePinnedToCore(parseTask, "ant_parse", PIPELINE_PARSE_STACK, nullptr,
+                            PIPELINE_PARSE_PRIORITY, &parseTaskHandle, PIPELINE_PARSE_CORE);
+    xTaskCreatePinnedToCore(notifyTask, "ble_notify", PIPELINE_NOTIFY_STACK, nullptr,
+                            PIPELINE_NOTIFY_PRIORITY, &notifyTaskHandle, PIPELINE_NOTIFY_CORE);
+
+    serialIngest.setDataCallback(onIngestData);
+    wsIngest.setDataCallback(onIngestData);
+    xTaskNotifyGive(parseTaskHandle);  // Pick up anything that arrived before the callback was set
+
+    LOG("[INFO] ANT+ → BLE pipeline started");
+}
+
+void pipeline_set_sample_listener(PipelineSampleListener listener) {
+    sampleListener = listener;
+}
+
+void pipeline_set_connected(bool connected) {
+    bleConnected = connected;
+}
+
+const PipelineStats &pipeline_get_stats() {
+    return stats;
+}
+
+void pipeline_log_stats() {
+    LOGF("[PIPE] rx→parse p50/p99/max: %u/%u/%u us, parse→notify: %u/%u/%u us, rx→notify: %u/%u/%u us",
+         stats.rxToParse.percentile(50), stats.rxToParse.percentile(99), stats.rxToParse.maxUs,
+         stats.parseToNotify.percentile(50), stats.parseToNotify.percentile(99), stats.parseToNotify.maxUs,
+         stats.rxToNotify.percentile(50), stats.rxToNotify.percentile(99), stats.rxToNotify.maxUs);
+    LOGF("[PIPE] notifies: %u, keepalives: %u, queue drops: %u",
+         stats.notifies, stats.keepalives, stats.queueDrops);
+}
@@ -0,0 +1,58 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <Arduino.h>
+#include "ant_parser.h"
+#include "ble_ftms.h"
+#include "latency_histogram.h"
+
+// ✅ ANT+ → BLE data path as three event-driven stages:
+//   UART RX   Arduino UART event task (HardwareSerial::onReceive) → SerialIngest ring,
+//             then wakes the parse task with a task notification
+//   WS RX     AsyncTCP task, binary /ws messages → WebSocketIngest ring, same wake-up
+//   Parse     drains both rings through ANTParser, queues a PipelineEvent per fresh sample
+//   Notify    blocks on the queue and runs BLEFTMS's notify scheduler as soon as a sample
+//             arrives (rate-limited, unchanged payloads skipped) or its keepalive is due
+// The RX/parse stages share the app core, notify runs next to the NimBLE host.
+
+#if CONFIG_FREERTOS_UNICORE
+    #define PIPELINE_PARSE_CORE 0
+    #define PIPELINE_NOTIFY_CORE 0
+#else
+    #define PIPELINE_PARSE_CORE 1
+    #define PIPELINE_NOTIFY_CORE 0
+#endif
+
+#define PIPELINE_PARSE_PRIORITY 5
+#define PIPELINE_NOTIFY_PRIORITY 4
+#define PIPELINE_PARSE_STACK 4096
+#define PIPELINE_NOTIFY_STACK 4096
+#define PIPELINE_QUEUE_LENGTH 16
+#define PIPELINE_REFRESH_MS 1000  // Re-run sensor fusion this often when no frames arrive
+#define PIPELINE_NO_AGE 0xFFFF  // Sample not tied to an ANT+ arrival (keepalive)
+
+struct PipelineEvent {
+    uint32_t rxUs;      // When the UART event task moved the bytes into the ring
+    uint32_t parsedUs;  // When the parse task finished decoding them
+};
+
+struct PipelineStats {
+    LatencyHistogram rxToParse;
+    LatencyHistogram parseToNotify;
+    LatencyHistogram rxToNotify;
+    uint32_t queueDrops;  // Events dropped because the notify stage was behind
+    uint32_t notifies;
+    uint32_t keepalives;
+};
+
+// ✅ Gets every snapshot the notify stage publishes (from the notify task; must not
+// block). rxAgeMs: ANT+ bytes arrival → publish, 0xFFFF for keepalives.
+typedef void (*PipelineSampleListener)(const FTMSDataStorage &data, uint32_t nowMs, uint16_t rxAgeMs);
+
+void pipeline_start(ANTParser &parser, BLEFTMS &ftms);
+void pipeline_set_sample_listener(PipelineSampleListener listener);
+void pipeline_set_connected(bool connected);
+const PipelineStats &pipeline_get_stats();
+void pipeline_log_stats();
+
+#endif  // PIPELINE_H
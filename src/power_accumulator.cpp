@@ -0,0 +1,66 @@
+#include "power_accumulator.h"
+
+void PowerAccumulator::reset() {
+    eventTotal = 0;
+    powerTotal = 0;
+    lastEventMs = 0;
+    duplicates = 0;
+    missedEvents = 0;
+    lastAccumulated = 0;
+    lastEventCount = 0;
+    primed = false;
+}
+
+bool PowerAccumulator::update(uint8_t eventCount, uint16_t accumulatedPower, uint32_t nowMs) {
+    if (!primed) {
+        // ✅ First page only sets the baseline
+        lastEventCount = eventCount;
+        lastAccumulated = accumulatedPower;
+        lastEventMs = nowMs;
+        primed = true;
+        return false;
+    }
+
+    uint8_t deltaEvents = eventCount - lastEventCount;  // ✅ Rollover-safe in 8 bits
+    if (deltaEvents == 0) {
+        duplicates++;
+        return false;
+    }
+
+    uint16_t deltaPower = accumulatedPower - lastAccumulated;  // ✅ Rollover-safe in 16 bits
+    if (deltaEvents > 1) missedEvents += deltaEvents - 1;
+
+    eventTotal += deltaEvents;
+    powerTotal += deltaPower;
+    lastEventCount = eventCount;
+    lastAccumulated = accumulatedPower;
+    lastEventMs = nowMs;
+    return true;
+}
+
+void PowerInterval::reset() {
+    lastEvents = 0;
+    lastPower = 0;
+    lastSource = DeviceType::Unknown;
+    primed = false;
+}
+
+bool PowerInterval::average(const FTMSDataStorage &data, uint16_t &watts) const {
+    if (!primed || data.power_source != lastSource || data.power_source == DeviceType::Unknown) {
+        return false;
+    }
+
+    uint32_t deltaEvents = data.power_event_total - lastEvents;
+    if (deltaEvents == 0 || deltaEvents > 0x7FFFFFFF) return false;  // Nothing new, or totals restarted
+
+    uint32_t deltaPower = data.power_accumulated_total - lastPower;
+    watts = (uint16_t)((deltaPower + deltaEvents / 2) / deltaEvents);
+    return true;
+}
+
+void PowerInterval::commit(const FTMSDataStorage &data) {
+    lastEvents = data.power_event_total;
+    lastPower = data.power_accumulated_total;
+    lastSource = data.power_source;
+    primed = true;
+}
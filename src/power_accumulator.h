@@ -0,0 +1,49 @@
+#ifndef POWER_ACCUMULATOR_H
+#define POWER_ACCUMULATOR_H
+
+#include <Arduino.h>
+#include "ftms_data.h"
+
+#define POWER_COASTING_MS 3000  // No new power event for this long: rider is coasting
+
+// ✅ Producer side, one per power source (power meter page 0x10, FE page 0x19).
+// Extends the 8-bit update event count and 16-bit accumulated power into 32-bit
+// running totals, so the average power over any interval is
+//   Δpower_total / Δevent_total
+// no matter how many broadcasts were dropped (up to 255 events) or repeated.
+struct PowerAccumulator {
+    uint32_t eventTotal;
+    uint32_t powerTotal;
+    uint32_t lastEventMs;
+    uint32_t duplicates;    // Pages repeating the previous event count
+    uint32_t missedEvents;  // Events skipped between two received pages
+    uint16_t lastAccumulated;
+    uint8_t lastEventCount;
+    bool primed;
+
+    PowerAccumulator() { reset(); }
+    void reset();
+
+    // Returns true if the page carried at least one new power event
+    bool update(uint8_t eventCount, uint16_t accumulatedPower, uint32_t nowMs);
+    bool isCoasting(uint32_t nowMs) const { return primed && nowMs - lastEventMs > POWER_COASTING_MS; }
+};
+
+// ✅ Consumer side: average power between two published FTMSDataStorage snapshots,
+// e.g. between two BLE notifies. O(1), no history kept.
+struct PowerInterval {
+    uint32_t lastEvents;
+    uint32_t lastPower;
+    DeviceType lastSource;
+    bool primed;
+
+    PowerInterval() { reset(); }
+    void reset();  // When the totals restart: the next interval starts from scratch
+
+    // False when there is no usable interval yet (first sample, source switched, or no
+    // new events); the caller then falls back to instantaneous power
+    bool average(const FTMSDataStorage &data, uint16_t &watts) const;
+    void commit(const FTMSDataStorage &data);
+};
+
+#endif  // POWER_ACCUMULATOR_H
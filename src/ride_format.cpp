@@ -0,0 +1,285 @@
+#include "ride_format.h"
+#include "crc16.h"
+
+static inline uint8_t *putUInt16(uint8_t *p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static inline uint8_t *putUInt32(uint8_t *p, uint32_t value) {
+    for (int i = 0; i < 4; i++) p[i] = (value >> (8 * i)) & 0xFF;
+    return p + 4;
+}
+
+static inline uint16_t getUInt16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t getUInt32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline size_t putVarint(uint8_t *p, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = v;
+    return n;
+}
+
+// False if the varint runs past `end` or is longer than 64 bits
+static inline bool getVarint(const uint8_t *&p, const uint8_t *end, uint64_t &v) {
+    v = 0;
+    for (int shift = 0; p < end && shift <= 63; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// ✅ The sample fields in mask-bit order, widened so deltas can go either way
+static inline void getFields(const RideSample &sample, int64_t *fields) {
+    fields[0] = sample.power;
+    fields[1] = sample.cadence;
+    fields[2] = sample.speed;
+    fields[3] = sample.heartRate;
+    fields[4] = sample.distance;
+    fields[5] = sample.energy;
+}
+
+static inline void setFields(RideSample &sample, const int64_t *fields) {
+    sample.power = fields[0];
+    sample.cadence = fields[1];
+    sample.speed = fields[2];
+    sample.heartRate = fields[3];
+    sample.distance = fields[4];
+    sample.energy = fields[5];
+}
+
+// ✅ Block and summary slots share the header: magic, payload, CRC over both
+static size_t sealSlot(uint8_t *out, char kind, size_t payloadLen, uint8_t samples, uint32_t firstSecond,
+                       uint32_t unixTime) {
+    uint8_t *p = out;
+    *p++ = 'R';
+    *p++ = kind;
+    p = putUInt16(p, payloadLen);
+    *p++ = samples;
+    *p++ = 0;
+    p = putUInt32(p, firstSecond);
+    p = putUInt32(p, unixTime);
+    uint16_t crc = crc16_ccitt(out, p - out);
+    crc = crc16_ccitt(out + RIDE_BLOCK_HEADER_BYTES, payloadLen, crc);
+    putUInt16(p, crc);
+    memset(out + RIDE_BLOCK_HEADER_BYTES + payloadLen, 0, RIDE_BLOCK_PAYLOAD_BYTES - payloadLen);
+    return RIDE_BLOCK_BYTES;
+}
+
+static bool slotCrcMatches(const uint8_t *slot, size_t payloadLen) {
+    uint16_t crc = crc16_ccitt(slot, RIDE_BLOCK_HEADER_BYTES - 2);
+    crc = crc16_ccitt(slot + RIDE_BLOCK_HEADER_BYTES, payloadLen, crc);
+    return crc == getUInt16(slot + RIDE_BLOCK_HEADER_BYTES - 2);
+}
+
+void RideSummary::add(const RideSample &sample) {
+    if (samples && sample.second - lastSecond > 1) pauses++;
+    if (!unixStart && sample.unixTime) unixStart = sample.unixTime - sample.second;
+    lastSecond = sample.second;
+    samples++;
+}
+
+size_t ride_write_summary(uint8_t *out, const RideSummary &summary) {
+    uint8_t *p = out + RIDE_BLOCK_HEADER_BYTES;
+    p = putUInt32(p, summary.samples);
+    p = putUInt32(p, summary.pauses);
+    p = putUInt32(p, summary.lastSecond);
+    putUInt32(p, summary.unixStart);
+    return sealSlot(out, 'S', RIDE_SUMMARY_PAYLOAD_BYTES, 0, 0, 0);
+}
+
+bool ride_read_summary(const uint8_t *slot, RideSummary &summary) {
+    if (slot[0] != 'R' || slot[1] != 'S' || getUInt16(slot + 2) != RIDE_SUMMARY_PAYLOAD_BYTES ||
+        !slotCrcMatches(slot, RIDE_SUMMARY_PAYLOAD_BYTES)) {
+        return false;
+    }
+    const uint8_t *p = slot + RIDE_BLOCK_HEADER_BYTES;
+    summary.samples = getUInt32(p);
+    summary.pauses = getUInt32(p + 4);
+    summary.lastSecond = getUInt32(p + 8);
+    summary.unixStart = getUInt32(p + 12);
+    return true;
+}
+
+bool ride_summarize(RideReader::ReadFn read, void *context, RideSummary &summary) {
+    RideReader reader;
+    if (!reader.open(read, context)) return false;
+    summary = RideSummary();
+    RideSample sample;
+    while (reader.next(sample)) summary.add(sample);
+    return true;
+}
+
+void ride_write_file_header(uint8_t *out) {
+    memcpy(out, RIDE_MAGIC, 4);
+    out[4] = RIDE_VERSION;
+    out[5] = 0;
+    putUInt16(out + 6, RIDE_BLOCK_BYTES);
+}
+
+RideBlockWriter::RideBlockWriter() : payloadLen(0), samples(0), firstSecond(0), unixTime(0), pauses(0), last() {}
+
+bool RideBlockWriter::add(const RideSample &sample) {
+    if (samples == RIDE_BLOCK_MAX_SAMPLES) return false;
+
+    RideSample base = {};  // ✅ First sample of a block: deltas from zero
+    if (samples == 0) {
+        base.second = sample.second;
+    } else {
+        base = last;
+    }
+
+    int64_t now[RIDE_FIELD_COUNT], before[RIDE_FIELD_COUNT];
+    getFields(sample, now);
+    getFields(base, before);
+
+    uint8_t record[RIDE_SAMPLE_MAX_BYTES];
+    size_t n = 1;
+    uint8_t mask = 0;
+    uint32_t seconds = sample.second - base.second;
+    if (samples > 0 && seconds != 1) {
+        mask |= RIDE_TIME_FLAG;
+        n += putVarint(record + n, seconds);
+    }
+    bool paused = samples > 0 && seconds > 1;
+    for (int i = 0; i < RIDE_FIELD_COUNT; i++) {
+        int64_t delta = now[i] - before[i];
+        if (delta == 0) continue;
+        mask |= 1 << i;
+        n += putVarint(record + n, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));  // Zigzag
+    }
+    record[0] = mask;
+
+    if (payloadLen + n > sizeof(payload)) return false;
+    if (samples == 0) {
+        firstSecond = sample.second;
+        unixTime = sample.unixTime;
+    }
+    if (paused) pauses++;
+    memcpy(payload + payloadLen, record, n);
+    payloadLen += n;
+    last = sample;
+    samples++;
+    return true;
+}
+
+size_t RideBlockWriter::finish(uint8_t *out) {
+    if (samples == 0) return 0;
+
+    memcpy(out + RIDE_BLOCK_HEADER_BYTES, payload, payloadLen);
+    sealSlot(out, 'B', payloadLen, samples, firstSecond, unixTime);
+
+    payloadLen = 0;
+    samples = 0;
+    pauses = 0;
+    return RIDE_BLOCK_BYTES;
+}
+
+// ✅ Same result as RideSummary::add() over the block's samples
+void RideBlockWriter::summarize(RideSummary &summary) const {
+    if (samples == 0) return;
+    if (summary.samples && firstSecond - summary.lastSecond > 1) summary.pauses++;
+    summary.pauses += pauses;
+    if (!summary.unixStart && unixTime) summary.unixStart = unixTime - firstSecond;
+    summary.samples += samples;
+    summary.lastSecond = last.second;
+}
+
+RideReader::RideReader()
+    : read(nullptr), context(nullptr), pos(0), end(0), samplesLeft(0), last(), firstSecond(0), unixTime(0),
+      blocks(0), badBlocks(0) {}
+
+bool RideReader::isRide(const uint8_t *data, size_t len) {
+    return len >= RIDE_FILE_HEADER_BYTES && memcmp(data, RIDE_MAGIC, 4) == 0;
+}
+
+bool RideReader::open(ReadFn readFn, void *readContext) {
+    uint8_t header[RIDE_FILE_HEADER_BYTES];
+    if (readFn(readContext, header, sizeof(header)) != sizeof(header) || !isRide(header, sizeof(header)) ||
+        header[4] != RIDE_VERSION || getUInt16(header + 6) != RIDE_BLOCK_BYTES) {
+        return false;
+    }
+    read = readFn;
+    context = readContext;
+    pos = end = 0;
+    samplesLeft = 0;
+    blocks = 0;
+    badBlocks = 0;
+    return true;
+}
+
+// ✅ Next block that checks out; a damaged one costs only its own slot
+bool RideReader::loadBlock() {
+    while (read && read(context, block, RIDE_BLOCK_BYTES) == RIDE_BLOCK_BYTES) {
+        size_t payloadLen = getUInt16(block + 2);
+        uint8_t samples = block[4];
+        if (block[0] == 'R' && block[1] == 'S') continue;  // The summary slot
+        if (block[0] != 'R' || block[1] != 'B' || payloadLen > RIDE_BLOCK_PAYLOAD_BYTES || samples == 0 ||
+            samples > RIDE_BLOCK_MAX_SAMPLES || !slotCrcMatches(block, payloadLen)) {
+            badBlocks++;
+            continue;
+        }
+
+        firstSecond = getUInt32(block + 6);
+        unixTime = getUInt32(block + 10);
+        pos = RIDE_BLOCK_HEADER_BYTES;
+        end = RIDE_BLOCK_HEADER_BYTES + payloadLen;
+        samplesLeft = samples;
+        blocks++;
+        return true;
+    }
+    return false;  // End of file, or a slot cut short by a crash
+}
+
+bool RideReader::next(RideSample &sample) {
+    for (;;) {
+        if (samplesLeft == 0) {
+            if (!loadBlock()) return false;
+            last = {};
+            last.second = firstSecond;
+        }
+        if (decodeSample(sample)) return true;
+        badBlocks++;  // The CRC passed, yet a sample doesn't parse: drop the rest of the block
+        samplesLeft = 0;
+    }
+}
+
+bool RideReader::decodeSample(RideSample &sample) {
+    const uint8_t *p = block + pos;
+    const uint8_t *stop = block + end;
+    if (p == stop) return false;
+
+    uint8_t mask = *p++;
+    uint64_t v = samplesLeft == block[4] ? 0 : 1;  // The block's first sample is at firstSecond
+    if ((mask & RIDE_TIME_FLAG) && !getVarint(p, stop, v)) return false;
+    RideSample current = last;
+    current.second = last.second + (uint32_t)v;
+
+    int64_t fields[RIDE_FIELD_COUNT];
+    getFields(last, fields);
+    for (int i = 0; i < RIDE_FIELD_COUNT; i++) {
+        if (!(mask & (1 << i))) continue;
+        if (!getVarint(p, stop, v)) return false;
+        fields[i] += (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+    }
+    setFields(current, fields);
+    current.unixTime = unixTime ? unixTime + (current.second - firstSecond) : 0;
+
+    pos = p - block;
+    samplesLeft--;
+    last = current;
+    sample = current;
+    return true;
+}
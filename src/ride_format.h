@@ -0,0 +1,128 @@
+#ifndef RIDE_FORMAT_H
+#define RIDE_FORMAT_H
+
+#include <Arduino.h>
+
+// ✅ Ride file: 1 Hz samples of the fused metrics, written by the on-device ride
+// recorder, read by the exporters and the host benchmark. All little-endian.
+//
+// File:   "RIDE" | version (u8) | flags (u8, 0) | block bytes (u16) | block...
+// Block:  a fixed RIDE_BLOCK_BYTES slot, written whole (one flash page):
+//         "RB" | payload bytes (u16) | samples (u8) | 0 (u8) | first second (u32) |
+//         unix time of the first sample (u32, 0 if the clock wasn't set) | crc16 (u16) |
+//         payload | zero padding
+//         The CRC (CRC-16/CCITT-FALSE) covers the 14 header bytes before it and the
+//         payload. A block that fails it (torn by a crash mid-write) is skipped; the
+//         next one is at the next slot.
+// Sample: mask (u8) | [varint seconds since the previous sample, if bit 7] |
+//         zigzag varint delta of each field whose bit (0-5) is set, in the order
+//         power (W), cadence (rpm), speed (0.01 km/h), heart rate (bpm),
+//         distance (m), energy (J). Fields not in the mask didn't change; without
+//         bit 7 the sample is one second after the previous one. The first sample of
+//         a block is at the block's first second, its deltas from all zeros, so every
+//         block decodes on its own.
+// Summary: the last slot of a finished ride, same header shape and CRC:
+//         "RS" | 16 (u16) | 0 | 0 | 0 (u32) | 0 (u32) | crc16 | samples (u32) |
+//         pauses (u32) | last second (u32) | unix time of second 0 (u32) | zero padding
+//         Lets the FIT export size its header without reading the ride. Readers skip it.
+// A steady ride costs 4-7 bytes per sample: roughly 40 hours per MB.
+
+#define RIDE_MAGIC "RIDE"
+#define RIDE_VERSION 1
+#define RIDE_FILE_HEADER_BYTES 8
+#define RIDE_BLOCK_BYTES 256  // SPI flash page
+#define RIDE_BLOCK_HEADER_BYTES 16
+#define RIDE_BLOCK_PAYLOAD_BYTES (RIDE_BLOCK_BYTES - RIDE_BLOCK_HEADER_BYTES)
+#define RIDE_BLOCK_MAX_SAMPLES 60  // A crash loses at most the minute being buffered
+#define RIDE_FIELD_COUNT 6
+#define RIDE_SAMPLE_MAX_BYTES (1 + 5 + RIDE_FIELD_COUNT * 5)
+#define RIDE_TIME_FLAG 0x80
+#define RIDE_SUMMARY_PAYLOAD_BYTES 16
+
+struct RideSample {
+    uint32_t second;     // Since the ride started
+    uint32_t unixTime;   // 0 if the clock wasn't set; stored once per block
+    uint16_t power;      // W
+    uint8_t cadence;     // rpm
+    uint16_t speed;      // 0.01 km/h
+    uint8_t heartRate;   // bpm
+    uint32_t distance;   // m, session total
+    uint32_t energy;     // J, session total
+};
+
+// ✅ What the FIT export needs before its first record. The recorder keeps one per file
+// as blocks are committed; ride_summarize() rebuilds it from the samples.
+struct RideSummary {
+    uint32_t samples;
+    uint32_t pauses;      // Gaps of more than a second between consecutive samples
+    uint32_t lastSecond;
+    uint32_t unixStart;   // Unix time of ride second 0; 0 if the clock was never set
+
+    RideSummary() : samples(0), pauses(0), lastSecond(0), unixStart(0) {}
+    void add(const RideSample &sample);
+};
+
+void ride_write_file_header(uint8_t *out);
+size_t ride_write_summary(uint8_t *out, const RideSummary &summary);  // A whole RIDE_BLOCK_BYTES slot
+bool ride_read_summary(const uint8_t *slot, RideSummary &summary);  // False unless a valid summary slot
+
+// ✅ Collects samples into one block; no allocation
+class RideBlockWriter {
+public:
+    RideBlockWriter();
+    // False if the sample doesn't fit: finish() the block and add it to the next one
+    bool add(const RideSample &sample);
+    // The whole RIDE_BLOCK_BYTES slot into `out`, then starts an empty block.
+    // Returns 0 if the block is empty.
+    size_t finish(uint8_t *out);
+    void summarize(RideSummary &summary) const;  // Adds this block's samples; call before finish()
+
+    uint8_t getSamples() const { return samples; }
+    size_t getPayloadBytes() const { return payloadLen; }
+
+private:
+    uint8_t payload[RIDE_BLOCK_PAYLOAD_BYTES];
+    size_t payloadLen;
+    uint8_t samples;
+    uint32_t firstSecond;
+    uint32_t unixTime;
+    uint32_t pauses;
+    RideSample last;
+};
+
+// ✅ Reads a ride file through `read` (a File, or memory on the host) one block at a
+// time, so a ride of any length needs RIDE_BLOCK_BYTES of RAM
+class RideReader {
+public:
+    typedef size_t (*ReadFn)(void *context, uint8_t *out, size_t len);
+
+    RideReader();
+    bool open(ReadFn read, void *context);  // False if it isn't a ride file
+    bool next(RideSample &sample);  // False at the end; the summary slot is skipped
+
+    uint32_t getBlocks() const { return blocks; }
+    uint32_t getBadBlocks() const { return badBlocks; }  // Skipped: CRC or format errors
+
+    static bool isRide(const uint8_t *data, size_t len);
+
+private:
+    bool loadBlock();
+    bool decodeSample(RideSample &sample);
+
+    ReadFn read;
+    void *context;
+    uint8_t block[RIDE_BLOCK_BYTES];
+    size_t pos;
+    size_t end;
+    uint8_t samplesLeft;
+    RideSample last;
+    uint32_t firstSecond;
+    uint32_t unixTime;
+    uint32_t blocks;
+    uint32_t badBlocks;
+};
+
+// Reads the whole ride: for files cut short before their summary slot was written
+bool ride_summarize(RideReader::ReadFn read, void *context, RideSummary &summary);
+
+#endif  // RIDE_FORMAT_H
@@ -0,0 +1,265 @@
+#include "ride_recorder.h"
+#include <LittleFS.h>
+#include <atomic>
+#include <time.h>
+#include "logger.h"
+#include "seqlock.h"
+#include "storage.h"
+
+static std::atomic<bool> mounted(false);
+static std::atomic<bool> rideActive(false);
+static RideStats stats;
+
+// ✅ Set from the recorder task, read by the /fit handler: the open file's summary
+static std::atomic<uint32_t> openSeq(0);  // 0 when no file is open
+static SeqLock<RideSummary> openSummary;
+
+// ✅ Only the recorder task touches these
+static RideBlockWriter writer;
+static uint8_t blockBuffer[RIDE_FILE_HEADER_BYTES + RIDE_BLOCK_BYTES];
+static File rideFile;
+static RideSummary summary;  // rideFile's blocks written so far
+static uint32_t rideSeq = 0;  // Newest ride on flash
+static uint32_t rideStartMs = 0;
+static uint32_t lastMovingMs = 0;
+static uint32_t lastSecond = 0;
+
+static bool mountFilesystem() {
+    if (!storage_mount()) {
+        LOG("[ERROR] Rides: no filesystem, recorder off");
+        return false;
+    }
+    if (!LittleFS.exists(RIDE_DIR)) LittleFS.mkdir(RIDE_DIR);
+
+    rideSeq = storage_prune(RIDE_DIR, RIDE_EXTENSION, 0);
+    LOGF("[INFO] Rides: %u on flash", (unsigned)rideSeq);
+    return true;
+}
+
+size_t ride_read_file(void *context, uint8_t *out, size_t len) {
+    return static_cast<File *>(context)->read(out, len);
+}
+
+static bool readSummarySlot(File &file, RideSummary &slotSummary) {
+    uint8_t slot[RIDE_BLOCK_BYTES];
+    size_t size = file.size();
+    if (size < RIDE_FILE_HEADER_BYTES + RIDE_BLOCK_BYTES || (size - RIDE_FILE_HEADER_BYTES) % RIDE_BLOCK_BYTES) {
+        return false;
+    }
+    return file.seek(size - RIDE_BLOCK_BYTES) && file.read(slot, sizeof(slot)) == sizeof(slot) &&
+           ride_read_summary(slot, slotSummary);
+}
+
+// ✅ A torn last block is padded out to a whole (bad) slot, so the summary lands on a
+// slot boundary
+static bool appendSummarySlot(const char *path, const RideSummary &slotSummary) {
+    File file = LittleFS.open(path, "a");
+    if (!file || file.size() < RIDE_FILE_HEADER_BYTES) return false;
+    size_t torn = (file.size() - RIDE_FILE_HEADER_BYTES) % RIDE_BLOCK_BYTES;
+    size_t padding = torn ? RIDE_BLOCK_BYTES - torn : 0;
+    memset(blockBuffer, 0, padding);
+    bool written = file.write(blockBuffer, padding) == padding;
+    size_t n = ride_write_summary(blockBuffer, slotSummary);
+    written = written && file.write(blockBuffer, n) == n;
+    file.close();
+    return written;
+}
+
+// ✅ Rides cut short by a reset, or whose summary couldn't be written, have no summary
+// slot: read them once here, so /fit doesn't have to
+static void finalizeRides() {
+    char path[32];
+    uint32_t oldest = rideSeq > RIDE_MAX_FILES ? rideSeq - RIDE_MAX_FILES + 1 : 1;
+    for (uint32_t seq = oldest; seq <= rideSeq; seq++) {
+        storage_numbered_path(path, sizeof(path), RIDE_DIR, RIDE_EXTENSION, seq);
+        if (!LittleFS.exists(path)) continue;
+        File file = LittleFS.open(path, "r");
+        RideSummary found;
+        bool finished = !file || readSummarySlot(file, found) || !file.seek(0) ||
+                        !ride_summarize(ride_read_file, &file, found);
+        file.close();
+        if (finished) continue;
+        if (!appendSummarySlot(path, found)) stats.writeErrors++;
+        LOGF("[INFO] Rides: finalized %s, %u samples", path, (unsigned)found.samples);
+    }
+}
+
+// ✅ Header (new ride) and block go out in one write, one flash page for the block
+static void writeBlock() {
+    size_t offset = 0;
+    if (!rideFile) {
+        char path[32];
+        rideSeq++;
+        if (rideSeq > RIDE_MAX_FILES) storage_prune(RIDE_DIR, RIDE_EXTENSION, rideSeq - RIDE_MAX_FILES + 1);
+        storage_numbered_path(path, sizeof(path), RIDE_DIR, RIDE_EXTENSION, rideSeq);
+        rideFile = LittleFS.open(path, "w");
+        if (!rideFile) {
+            stats.writeErrors++;
+            writer.finish(blockBuffer);  // Drop the block rather than retry forever
+            return;
+        }
+        summary = RideSummary();
+        openSummary.write(summary);
+        openSeq = rideSeq;
+        ride_write_file_header(blockBuffer);
+        offset = RIDE_FILE_HEADER_BYTES;
+        LOGF("[INFO] Rides: recording %s", path);
+    }
+
+    size_t payload = writer.getPayloadBytes();
+    RideSummary next = summary;
+    writer.summarize(next);
+    size_t n = offset + writer.finish(blockBuffer + offset);
+    if (rideFile.write(blockBuffer, n) != n) {
+        // ✅ A torn block is skipped by the reader; the rest goes to a new file. This one
+        // is finished with the blocks already committed, so /fit can export it now.
+        char path[32];
+        stats.writeErrors++;
+        rideFile.close();
+        storage_numbered_path(path, sizeof(path), RIDE_DIR, RIDE_EXTENSION, rideSeq);
+        if (!appendSummarySlot(path, summary)) stats.writeErrors++;
+        openSeq = 0;
+        return;
+    }
+    rideFile.flush();  // ✅ Committed: survives a crash or power loss from here on
+    summary = next;
+    openSummary.write(summary);
+    stats.blocks++;
+    stats.payloadBytes += payload;
+}
+
+static void endRide() {
+    if (writer.getSamples()) writeBlock();
+    if (rideFile) {
+        size_t n = ride_write_summary(blockBuffer, summary);
+        if (rideFile.write(blockBuffer, n) != n) stats.writeErrors++;
+        rideFile.close();
+        openSeq = 0;  // After the close: /fit finds the summary slot from here on
+    }
+    rideActive = false;
+    LOGF("[INFO] Rides: ride over after %u s", (unsigned)lastSecond);
+}
+
+static void recordSecond(const FTMSDataStorage &data, uint32_t nowMs) {
+    bool moving = data.hasData && (data.instantaneous_power > 0 || data.cadence > 0 || data.speed >= 0.5f);
+    if (moving) lastMovingMs = nowMs;
+
+    if (!rideActive) {
+        if (!moving) return;
+        rideActive = true;
+        rideStartMs = nowMs;
+        lastSecond = UINT32_MAX;
+        stats.rides++;
+    } else if (nowMs - lastMovingMs >= RIDE_END_IDLE_MS) {
+        endRide();
+        return;
+    }
+    if (nowMs - lastMovingMs >= RIDE_PAUSE_MS) {
+        // ✅ Paused: commit what's buffered; the next sample's time delta covers the gap
+        if (writer.getSamples()) writeBlock();
+        return;
+    }
+
+    RideSample sample;
+    sample.second = (nowMs - rideStartMs + RIDE_SAMPLE_INTERVAL_MS / 2) / 1000;
+    if (sample.second == lastSecond) return;  // Task ran late, then early
+    time_t now = time(nullptr);
+    sample.unixTime = now >= RIDE_MIN_UNIX_TIME ? (uint32_t)now : 0;
+    sample.power = data.instantaneous_power;
+    sample.cadence = data.cadence;
+    sample.speed = (uint16_t)(data.speed * 100 + 0.5f);
+    sample.heartRate = data.heart_rate;
+    sample.distance = data.distance;
+    sample.energy = data.energy_joules;
+
+    if (!writer.add(sample)) {
+        writeBlock();
+        writer.add(sample);
+    }
+    lastSecond = sample.second;
+    stats.samples++;
+}
+
+static void recorderTask(void *arg) {
+    ANTParser &parser = *static_cast<ANTParser *>(arg);
+    if (!mountFilesystem()) {
+        vTaskDelete(nullptr);
+        return;
+    }
+    finalizeRides();
+    mounted = true;
+
+    TickType_t wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(RIDE_SAMPLE_INTERVAL_MS));
+        recordSecond(parser.getFTMSData(), millis());  // ✅ Seqlock copy: never blocks the parser
+    }
+}
+
+void ride_start(ANTParser &parser) {
+    static bool started = false;
+    if (started) return;
+    started = true;
+    xTaskCreate(recorderTask, "rides", RIDE_STACK, &parser, RIDE_PRIORITY, nullptr);
+}
+
+bool ride_is_active() {
+    return rideActive;
+}
+
+size_t ride_list_json(char *out, size_t size) {
+    size_t n = 0;
+    auto append = [&](const char *format, auto... args) {
+        if (n >= size) return;
+        int written = snprintf(out + n, size - n, format, args...);
+        if (written > 0) n += written;
+    };
+
+    append("{\"type\":\"rides\",\"rides\":[");
+    File dir = mounted ? LittleFS.open(RIDE_DIR) : File();
+    bool first = true;
+    if (dir && dir.isDirectory()) {
+        for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+            append("%s{\"name\":\"%s\",\"bytes\":%u}", first ? "" : ",", file.name(), (unsigned)file.size());
+            file.close();
+            first = false;
+        }
+    }
+    append("]}");
+
+    if (n >= size) {
+        if (size) out[0] = '\0';
+        return 0;
+    }
+    return n;
+}
+
+bool ride_path(char *path, size_t size, const char *name) {
+    size_t digits = strspn(name, "0123456789");
+    if (digits == 0 || digits > 8 || strcmp(name + digits, RIDE_EXTENSION) != 0) return false;
+    return snprintf(path, size, RIDE_DIR "/%s", name) < (int)size;
+}
+
+bool ride_get_summary(File &file, const char *name, RideSummary &found) {
+    uint32_t seq = strtoul(name, nullptr, 10);
+    if (seq && openSeq == seq) {
+        RideSummary copy = openSummary.read();
+        if (openSeq == seq) {  // Still the same file, not the next ride's empty summary
+            found = copy;
+            return file.seek(0);
+        }
+    }
+    if (readSummarySlot(file, found)) return file.seek(0);
+    // No slot: this boot couldn't write it (flash full). Rare, so read the ride for it.
+    return file.seek(0) && ride_summarize(ride_read_file, &file, found) && file.seek(0);
+}
+
+const RideStats &ride_get_stats() {
+    return stats;
+}
+
+void ride_log_stats() {
+    LOGF("[RIDE] %s, samples: %u, blocks: %u, payload: %u B, rides: %u, errors: %u",
+         rideActive ? "recording" : "idle", stats.samples, stats.blocks, stats.payloadBytes, stats.rides,
+         stats.writeErrors);
+}
@@ -0,0 +1,56 @@
+#ifndef RIDE_RECORDER_H
+#define RIDE_RECORDER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "ant_parser.h"
+#include "ride_format.h"
+
+// ✅ Workout recorder: the fused metrics once a second, in the ride format of
+// ride_format.h, one file per ride on LittleFS (RIDE_DIR/<seq>.ride, the oldest
+// deleted beyond RIDE_MAX_FILES). A ride starts with the first second of riding
+// (power, cadence or speed) and ends after RIDE_END_IDLE_MS without any; stops longer
+// than RIDE_PAUSE_MS are left out of the file. A low-priority task copies the parser's
+// snapshot and writes whole 256-byte blocks, so neither the parse nor the notify task
+// ever waits for flash. Rides outlive BLE disconnects, app crashes and reboots; they
+// are listed at /rides and downloaded from /rides/<seq>.ride.
+//
+// A ride that ends, or is cut short by a write error, gets a summary slot (RideSummary)
+// as its last block; one cut short by a reset gets it at the next boot, on the
+// recorder task.
+
+#define RIDE_DIR "/rides"
+#define RIDE_EXTENSION ".ride"
+#define RIDE_MAX_FILES 30
+#define RIDE_SAMPLE_INTERVAL_MS 1000
+#define RIDE_PAUSE_MS 10000      // Stopped for longer: seconds aren't recorded until moving again
+#define RIDE_END_IDLE_MS 600000  // Stopped for longer: the ride is over
+#define RIDE_MIN_UNIX_TIME 1704067200  // 2024-01-01: anything earlier means SNTP hasn't set the clock
+#define RIDE_PRIORITY 1
+#define RIDE_STACK 4096
+
+struct RideStats {
+    uint32_t samples;      // Samples added to blocks
+    uint32_t blocks;       // Blocks written
+    uint32_t payloadBytes; // Encoded sample bytes, before padding to whole blocks
+    uint32_t rides;        // Rides started
+    uint32_t writeErrors;
+};
+
+void ride_start(ANTParser &parser);
+bool ride_is_active();
+// {"type":"rides","rides":[{"name":"00000003.ride","bytes":1234},...]}; 0 if it didn't fit
+size_t ride_list_json(char *out, size_t size);
+// RIDE_DIR/<name> if `name` names a ride file ("00000003.ride"); false for anything else
+bool ride_path(char *path, size_t size, const char *name);
+// RideReader::ReadFn over an open ride File passed as `context`
+size_t ride_read_file(void *context, uint8_t *out, size_t len);
+// ✅ The ride's summary, normally without reading the ride: the recorder's own copy
+// while it's being recorded, the summary slot once it's over; a full read only if the
+// slot couldn't be written. False if it isn't a ride file. Leaves `file` (RIDE_DIR/<name>,
+// open for reading) at its start.
+bool ride_get_summary(File &file, const char *name, RideSummary &summary);
+const RideStats &ride_get_stats();
+void ride_log_stats();
+
+#endif  // RIDE_RECORDER_H
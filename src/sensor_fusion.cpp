@@ -0,0 +1,136 @@
+#include "sensor_fusion.h"
+#include "logger.h"
+
+SensorFusion::SensorFusion() {
+    reset();
+}
+
+void SensorFusion::reset() {
+    memset(sources, 0, sizeof(sources));
+    sourceCount = 0;
+    for (uint8_t m = 0; m < (uint8_t)Metric::Count; m++) {
+        selected[m] = DeviceType::Unknown;
+    }
+}
+
+// ✅ Higher wins; 0 means this device type never feeds the metric
+uint8_t SensorFusion::priority(Metric metric, DeviceType type) {
+    switch (metric) {
+        case Metric::Power:
+            switch (type) {
+                case DeviceType::PowerMeter: return 2;
+                case DeviceType::FitnessEquipment: return 1;
+                default: return 0;
+            }
+        case Metric::Cadence:
+            switch (type) {
+                case DeviceType::BikeCadence: return 4;
+                case DeviceType::CombinedSpeedCadence: return 3;
+                case DeviceType::PowerMeter: return 2;
+                case DeviceType::FitnessEquipment: return 1;
+                default: return 0;
+            }
+        case Metric::Speed:
+            switch (type) {
+                case DeviceType::BikeSpeed: return 3;
+                case DeviceType::CombinedSpeedCadence: return 2;
+                case DeviceType::FitnessEquipment: return 1;
+                default: return 0;
+            }
+        case Metric::HeartRate:
+            switch (type) {
+                case DeviceType::HeartRate: return 2;
+                case DeviceType::FitnessEquipment: return 1;
+                default: return 0;
+            }
+        default:
+            return 0;
+    }
+}
+
+FusionSource *SensorFusion::findSource(DeviceType type, uint16_t deviceNumber, uint32_t nowMs) {
+    FusionSource *stalest = nullptr;
+    uint32_t stalestAge = 0;
+
+    for (uint8_t i = 0; i < sourceCount; i++) {
+        FusionSource &src = sources[i];
+        if (src.type == type && src.deviceNumber == deviceNumber) return &src;
+
+        uint32_t newest = 0;
+        for (uint8_t m = 0; m < (uint8_t)Metric::Count; m++) {
+            if (src.updatedMs[m] > newest) newest = src.updatedMs[m];
+        }
+        if (!stalest || nowMs - newest > stalestAge) {
+            stalest = &src;
+            stalestAge = nowMs - newest;
+        }
+    }
+
+    // ✅ New sensor: take a free slot, or recycle the one silent the longest
+    FusionSource *slot = (sourceCount < FUSION_MAX_SOURCES) ? &sources[sourceCount++] : stalest;
+    memset(slot, 0, sizeof(*slot));
+    slot->type = type;
+    slot->deviceNumber = deviceNumber;
+    LOGF("[FUSION] New source: type %d, device %u", (int)type, deviceNumber);
+    return slot;
+}
+
+void SensorFusion::update(DeviceType type, uint16_t deviceNumber, Metric metric, float value, uint32_t nowMs) {
+    if (priority(metric, type) == 0) return;
+
+    FusionSource *src = findSource(type, deviceNumber, nowMs);
+    uint8_t m = (uint8_t)metric;
+    src->value[m] = value;
+    src->updatedMs[m] = nowMs;
+    src->providedMask |= (1 << m);
+}
+
+bool SensorFusion::selectValue(Metric metric, uint32_t nowMs, float &value) {
+    uint8_t m = (uint8_t)metric;
+    const FusionSource *best = nullptr;
+    uint8_t bestPriority = 0;
+
+    for (uint8_t i = 0; i < sourceCount; i++) {
+        const FusionSource &src = sources[i];
+        if (!(src.providedMask & (1 << m))) continue;
+        if (nowMs - src.updatedMs[m] > FUSION_STALE_MS) continue;  // ✅ Drop stale sources
+
+        uint8_t p = priority(metric, src.type);
+        // Same priority (e.g. two power meters): the most recently updated wins
+        if (p > bestPriority || (p == bestPriority && best && src.updatedMs[m] > best->updatedMs[m])) {
+            best = &src;
+            bestPriority = p;
+        }
+    }
+
+    DeviceType chosen = best ? best->type : DeviceType::Unknown;
+    if (chosen != selected[m]) {
+        LOGF("[FUSION] Metric %d now from type %d", m, (int)chosen);
+        selected[m] = chosen;
+    }
+
+    value = best ? best->value[m] : 0;
+    return best != nullptr;
+}
+
+bool SensorFusion::apply(FTMSDataStorage &out, uint32_t nowMs) {
+    float power, cadence, speed, heartRate;
+    selectValue(Metric::Power, nowMs, power);
+    selectValue(Metric::Cadence, nowMs, cadence);
+    selectValue(Metric::Speed, nowMs, speed);
+    selectValue(Metric::HeartRate, nowMs, heartRate);
+
+    // ✅ Round, don't truncate: rates from revolution sensors are fractional
+    uint16_t fusedPower = (uint16_t)(power + 0.5f);
+    uint8_t fusedCadence = cadence >= 254.5f ? 254 : (uint8_t)(cadence + 0.5f);
+    uint8_t fusedHeartRate = (uint8_t)(heartRate + 0.5f);
+
+    bool changed = out.instantaneous_power != fusedPower || out.cadence != fusedCadence ||
+                   out.speed != speed || out.heart_rate != fusedHeartRate;
+
+    out.instantaneous_power = fusedPower;
+    out.cadence = fusedCadence;
+    out.speed = speed;
+    out.heart_rate = fusedHeartRate;
+    return changed;
+}
@@ -0,0 +1,58 @@
+#ifndef SENSOR_FUSION_H
+#define SENSOR_FUSION_H
+
+#include <Arduino.h>
+#include "ftms_data.h"
+
+#define FUSION_MAX_SOURCES 8
+#define FUSION_STALE_MS 3000  // ANT+ sensors broadcast at ~4 Hz; 3 s of silence means gone
+#define ANT_DEVICE_NUMBER_ANY 0  // The legacy serial frame carries no device number
+
+// ✅ Metrics more than one sensor can report
+enum class Metric : uint8_t {
+    Power,
+    Cadence,
+    Speed,
+    HeartRate,
+    Count
+};
+
+struct FusionSource {
+    DeviceType type;
+    uint16_t deviceNumber;
+    uint8_t providedMask;  // Bit per Metric this source has reported
+    float value[(uint8_t)Metric::Count];
+    uint32_t updatedMs[(uint8_t)Metric::Count];
+};
+
+// Keeps the latest timestamped value of every metric per (DeviceType, device number)
+// and picks one source per metric by priority, ignoring sources that went stale:
+//   Power      power meter > trainer
+//   Cadence    cadence sensor > speed/cadence sensor > power meter > trainer
+//   Speed      speed sensor > speed/cadence sensor > trainer
+//   Heart rate HR strap > trainer
+// Fixed-size, no allocation; update() is O(sources) to find the slot.
+class SensorFusion {
+public:
+    SensorFusion();
+    void update(DeviceType type, uint16_t deviceNumber, Metric metric, float value, uint32_t nowMs);
+
+    // Write the fused metrics into `out`; returns true if any of them changed
+    bool apply(FTMSDataStorage &out, uint32_t nowMs);
+    void reset();
+
+    // Which source currently feeds a metric (DeviceType::Unknown if none is fresh)
+    DeviceType getSelectedSource(Metric metric) const { return selected[(uint8_t)metric]; }
+
+    static uint8_t priority(Metric metric, DeviceType type);
+
+private:
+    FusionSource *findSource(DeviceType type, uint16_t deviceNumber, uint32_t nowMs);
+    bool selectValue(Metric metric, uint32_t nowMs, float &value);
+
+    FusionSource sources[FUSION_MAX_SOURCES];
+    uint8_t sourceCount;
+    DeviceType selected[(uint8_t)Metric::Count];
+};
+
+#endif  // SENSOR_FUSION_H
@@ -0,0 +1,60 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// ✅ Single-writer, multi-reader sequence lock for small trivially-copyable structs.
+// The writer never blocks; a reader retries if the writer published while it was
+// copying, so it always gets one whole version (never new power with old cadence).
+// The value is held as relaxed atomic words so concurrent copies are not a data race.
+template <typename T>
+class SeqLock {
+    static const size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+public:
+    SeqLock() : sequence(0) {
+        T initial;
+        write(initial);
+    }
+
+    // Writer side: only one task may call this
+    void write(const T &value) {
+        uint32_t raw[WORDS] = {0};
+        memcpy(raw, &value, sizeof(T));
+
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);  // Odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i].store(raw[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Reader side: any number of tasks, lock-free
+    T read() const {
+        uint32_t raw[WORDS];
+        uint32_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++) {
+                raw[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        T value;
+        memcpy(&value, raw, sizeof(T));
+        return value;
+    }
+
+    uint32_t version() const { return sequence.load(std::memory_order_acquire) >> 1; }
+
+private:
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> words[WORDS];
+};
+
+#endif  // SEQLOCK_H
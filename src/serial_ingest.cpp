@@ -0,0 +1,71 @@
+#include "serial_ingest.h"
+#include "logger.h"
+
+SerialIngest serialIngest;
+
+SerialIngest::SerialIngest() : port(nullptr), dataCallback(nullptr), oldestPendingUs(0), stalled(false) {
+    stats = {};
+}
+
+void SerialIngest::setDataCallback(void (*callback)()) {
+    dataCallback = callback;
+}
+
+void SerialIngest::begin(HardwareSerial &uart, unsigned long baud) {
+    port = &uart;
+
+    // ✅ Driver buffer must be sized before begin() installs the UART driver
+    port->setRxBufferSize(SERIAL_DRIVER_RX_BUFFER);
+    port->begin(baud);
+
+    // ✅ Woken by the UART event queue (FIFO threshold or RX timeout), not by polling
+    port->onReceive([this]() { pump(); });
+    port->onReceiveError([this](hardwareSerial_error_t error) {
+        if (error == UART_BUFFER_FULL_ERROR || error == UART_FIFO_OVF_ERROR) {
+            stats.uartOverflows++;
+        }
+    });
+
+    LOGF("[INFO] Serial ingest: %lu baud, %u byte ring", baud, (unsigned)SerialRing::capacity());
+}
+
+// ✅ The UART event task and, after a stall, the consumer both pump: whichever finds
+// the flag taken leaves it to the other, which looks at the driver again on its way out
+void SerialIngest::pump() {
+    if (!port) return;
+    do {
+        if (pumping.test_and_set(std::memory_order_acquire)) return;
+        pumpOnce();
+        pumping.clear(std::memory_order_release);
+    } while (!stalled.load(std::memory_order_relaxed) && port->available() > 0);
+}
+
+void SerialIngest::pumpOnce() {
+    // ✅ Stamp before committing so the consumer never sees bytes with an older stamp
+    if (ring.size() == 0) oldestPendingUs = micros();
+    uint32_t before = stats.bytesIn;
+    stalled.store(false, std::memory_order_relaxed);
+    int pending;
+    while ((pending = port->available()) > 0) {
+        uint8_t *span;
+        size_t space = ring.getWritable(&span);
+        if (space == 0) {
+            // ✅ Leave the rest in the driver buffer; the parser's resume() pumps it
+            stats.overruns++;
+            stalled.store(true, std::memory_order_release);
+            break;
+        }
+
+        size_t n = port->read(span, space < (size_t)pending ? space : (size_t)pending);
+        if (n == 0) break;
+        ring.commit(n);
+        stats.bytesIn += n;
+    }
+
+    uint32_t fill = ring.size();
+    if (fill > stats.highWater) stats.highWater = fill;
+
+    if (stats.bytesIn != before && dataCallback) {
+        dataCallback();
+    }
+}
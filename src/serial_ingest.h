@@ -0,0 +1,60 @@
+#ifndef SERIAL_INGEST_H
+#define SERIAL_INGEST_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "spsc_ring.h"
+
+// ✅ Link from the Raspberry Pi. 921600 baud is well inside what the ESP32 UART and
+// CP210x/CH34x adapters sustain; override with -D SERIAL_BAUDRATE=... if needed.
+#ifndef SERIAL_BAUDRATE
+    #define SERIAL_BAUDRATE 921600
+#endif
+
+#ifndef SERIAL_RING_SIZE
+    #define SERIAL_RING_SIZE 8192  // Must be a power of two
+#endif
+
+#define SERIAL_DRIVER_RX_BUFFER 2048  // UART driver buffer behind the hardware FIFO
+
+typedef SpscRing<SERIAL_RING_SIZE> SerialRing;
+
+struct SerialIngestStats {
+    uint32_t bytesIn;        // Bytes moved from the UART driver into the ring
+    uint32_t overruns;       // Times the ring was full while the UART still had data
+    uint32_t uartOverflows;  // FIFO/driver buffer overflows reported by the UART (bytes lost)
+    uint32_t highWater;      // Highest ring fill level seen, in bytes
+};
+
+// Producer for the ANT+ serial ring. pump() runs on the UART event task via
+// HardwareSerial::onReceive and reads the driver buffer in bulk straight into the ring;
+// ANTParser::readSerial() is the only consumer. A pump that found the ring full leaves
+// the rest in the driver buffer, and no UART event may follow on a quiet link, so the
+// consumer calls resume() once it has made room. One caller pumps at a time.
+class SerialIngest {
+public:
+    SerialIngest();
+    void begin(HardwareSerial &port, unsigned long baud);
+    void pump();
+    void resume() { if (stalled.load(std::memory_order_acquire)) pump(); }  // Consumer side, after draining
+    void setDataCallback(void (*callback)());  // ✅ Called from pump() after new bytes land in the ring
+
+    SerialRing &getRing() { return ring; }
+    const SerialIngestStats &getStats() const { return stats; }
+    uint32_t getOldestPendingMicros() const { return oldestPendingUs; }  // Arrival time of the oldest unread bytes
+
+private:
+    HardwareSerial *port;
+    SerialRing ring;
+    SerialIngestStats stats;
+    void (*dataCallback)();
+    volatile uint32_t oldestPendingUs;
+    std::atomic<bool> stalled;  // The last pump stopped at a full ring
+    std::atomic_flag pumping = ATOMIC_FLAG_INIT;
+
+    void pumpOnce();
+};
+
+extern SerialIngest serialIngest;
+
+#endif  // SERIAL_INGEST_H
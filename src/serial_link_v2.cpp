@@ -0,0 +1,199 @@
+#include "serial_link_v2.h"
+#include "logger.h"
+#include "metrics.h"
+
+namespace {
+
+// Returns the decoded length, 0 if `in` isn't valid COBS or doesn't fit `out`
+size_t cobsDecode(const uint8_t *in, size_t len, uint8_t *out, size_t outSize) {
+    size_t ip = 0, op = 0;
+    while (ip < len) {
+        uint8_t code = in[ip++];
+        size_t n = code - 1;
+        if (code == 0 || len - ip < n || outSize - op < n) return 0;
+        memcpy(out + op, in + ip, n);
+        op += n;
+        ip += n;
+        if (code != 0xFF && ip < len) {
+            if (op == outSize) return 0;
+            out[op++] = 0;
+        }
+    }
+    return op;
+}
+
+}  // namespace
+
+SerialLinkV2Decoder::SerialLinkV2Decoder() {
+    reset();
+    stats = {};
+}
+
+void SerialLinkV2Decoder::reset() {
+    encodedLen = 0;
+    overflow = false;
+    haveSequence = false;
+    expectedSequence = 0;
+    consecutiveErrors = 0;
+}
+
+void SerialLinkV2Decoder::packetError(uint32_t &counter) {
+    counter++;
+    if (consecutiveErrors < 0xFF) consecutiveErrors++;
+}
+
+void SerialLinkV2Decoder::feed(const uint8_t *data, size_t len, FrameHandler handler, void *context) {
+    while (len > 0) {
+        const uint8_t *delimiter = (const uint8_t *)memchr(data, 0, len);
+        size_t n = delimiter ? delimiter - data : len;
+
+        if (!overflow) {
+            if (encodedLen + n > sizeof(encoded)) {
+                overflow = true;
+            } else {
+                memcpy(encoded + encodedLen, data, n);
+                encodedLen += n;
+            }
+        }
+        if (!delimiter) return;  // Rest of the packet comes with the next feed()
+
+        if (overflow) packetError(stats.formatErrors);
+        else if (encodedLen > 0) processPacket(handler, context);  // Back-to-back delimiters are fine
+        encodedLen = 0;
+        overflow = false;
+        data += n + 1;
+        len -= n + 1;
+    }
+}
+
+void SerialLinkV2Decoder::processPacket(FrameHandler handler, void *context) {
+    size_t len = cobsDecode(encoded, encodedLen, packet, sizeof(packet));
+    if (len < LINK_V2_HEADER_BYTES + LINK_V2_CRC_BYTES || packet[0] != LINK_V2_VERSION_BYTE) {
+        packetError(stats.formatErrors);
+        return;
+    }
+
+    size_t body = len - LINK_V2_CRC_BYTES;
+    uint16_t crc = packet[body] | (packet[body + 1] << 8);
+    if (crc16_ccitt(packet, body) != crc) {
+        packetError(stats.crcErrors);
+        metrics.increment(METRIC_CRC_FAILURES);
+        return;
+    }
+
+    // ✅ Check every message before delivering any
+    ANTFrame frame;
+    for (size_t pos = LINK_V2_HEADER_BYTES; pos < body; pos += frame.payload - (packet + pos) + frame.length) {
+        if (!parseMessage(pos, body, frame)) {
+            packetError(stats.formatErrors);
+            return;
+        }
+    }
+
+    uint8_t sequence = packet[1];
+    if (haveSequence) {
+        uint8_t gap = sequence - expectedSequence;
+        if (gap >= 0x80) {  // Behind: arrived late or twice; its data is stale
+            stats.reorders++;
+            metrics.increment(METRIC_LINK_REORDERS);
+            consecutiveErrors = 0;
+            return;
+        }
+        if (gap) {
+            stats.drops += gap;
+            metrics.increment(METRIC_LINK_DROPS, gap);
+        }
+    }
+    haveSequence = true;
+    expectedSequence = sequence + 1;
+    consecutiveErrors = 0;
+    stats.packets++;
+
+    for (size_t pos = LINK_V2_HEADER_BYTES; pos < body; pos += frame.payload - (packet + pos) + frame.length) {
+        parseMessage(pos, body, frame);
+        stats.messages++;
+        handler(context, frame);
+    }
+}
+
+// Message at `pos` of the packet body (which ends at `end`); false if malformed
+bool SerialLinkV2Decoder::parseMessage(size_t pos, size_t end, ANTFrame &frame) const {
+    const uint8_t *message = packet + pos;
+    size_t available = end - pos;
+
+    if (!(message[0] & LINK_V2_LONG_FORM)) {
+        frame.sync = ANT_SYNC_BYTE;
+        frame.deviceType = message[0];
+        frame.length = LINK_V2_SHORT_PAYLOAD;
+        frame.payload = message + 1;
+        return available >= 1 + LINK_V2_SHORT_PAYLOAD;
+    }
+
+    if (available < LINK_V2_LONG_OVERHEAD) return false;
+    frame.sync = (message[2] & LINK_V2_COMMAND_FLAG) ? CMD_SYNC_BYTE : ANT_SYNC_BYTE;
+    frame.deviceType = message[1];
+    frame.length = message[2] & LINK_V2_LENGTH_MASK;
+    frame.payload = message + LINK_V2_LONG_OVERHEAD;
+    return frame.length > 0 && frame.length <= ANT_FRAME_MAX_PAYLOAD &&
+           available - LINK_V2_LONG_OVERHEAD >= frame.length;
+}
+
+SerialLinkV2Encoder::SerialLinkV2Encoder() : len(0), messages(0) {}
+
+void SerialLinkV2Encoder::begin(uint8_t sequence) {
+    packet[0] = LINK_V2_VERSION_BYTE;
+    packet[1] = sequence;
+    len = LINK_V2_HEADER_BYTES;
+    messages = 0;
+}
+
+bool SerialLinkV2Encoder::add(uint8_t sync, uint8_t deviceType, const uint8_t *payload, uint8_t length) {
+    if (length == 0 || length > ANT_FRAME_MAX_PAYLOAD) return true;  // Not representable; skip
+
+    // ✅ Short form for plain ANT+ pages, the bulk of the traffic
+    bool shortForm = sync == ANT_SYNC_BYTE && length == LINK_V2_SHORT_PAYLOAD && !(deviceType & LINK_V2_LONG_FORM);
+    size_t overhead = shortForm ? 1 : LINK_V2_LONG_OVERHEAD;
+    if (len + overhead + length + LINK_V2_CRC_BYTES > sizeof(packet)) return false;
+
+    if (shortForm) {
+        packet[len++] = deviceType;
+    } else {
+        packet[len++] = LINK_V2_LONG_FORM;
+        packet[len++] = deviceType;
+        packet[len++] = length | (sync == CMD_SYNC_BYTE ? LINK_V2_COMMAND_FLAG : 0);
+    }
+    memcpy(packet + len, payload, length);
+    len += length;
+    messages++;
+    return true;
+}
+
+size_t SerialLinkV2Encoder::finish(uint8_t *out) {
+    uint16_t crc = crc16_ccitt(packet, len);
+    packet[len++] = crc & 0xFF;
+    packet[len++] = crc >> 8;
+
+    // ✅ COBS: each code byte gives the distance to the next zero (0xFF: none in 254 bytes)
+    size_t op = 1, codeAt = 0;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (packet[i] == 0) {
+            out[codeAt] = code;
+            codeAt = op++;
+            code = 1;
+            continue;
+        }
+        out[op++] = packet[i];
+        if (++code == 0xFF) {
+            out[codeAt] = code;
+            codeAt = op++;
+            code = 1;
+        }
+    }
+    out[codeAt] = code;
+    out[op++] = 0;  // Delimiter
+
+    len = LINK_V2_HEADER_BYTES;
+    messages = 0;
+    return op;
+}
@@ -0,0 +1,97 @@
+#ifndef SERIAL_LINK_V2_H
+#define SERIAL_LINK_V2_H
+
+#include <Arduino.h>
+#include "ant_frame_decoder.h"
+#include "crc16.h"
+
+// ✅ Serial link v2 (Pi → ESP32). Each packet carries a batch of ANT+ messages:
+//   version (0x02) | seq (u8) | message... | crc16 (u16, little-endian)
+//   message, short form: deviceType (bit 7 clear) | 8-byte payload
+//                        (an ANT+ broadcast page: 7-bit device type, 8 bytes)
+//   message, long form:  0x80 | deviceType | flags/length | payload
+//                        (flags/length bit 7: 0xF0 command, bits 0-5: length 1..32)
+// The CRC is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over everything before it.
+// The packet is COBS-encoded and ends with a 0x00 delimiter, so the decoder resyncs
+// on the next 0x00 whatever the payload holds. `seq` goes up by one per packet:
+// gaps count as drops, and a packet from behind (late or duplicated) counts as a
+// reorder and is dropped. Messages of a packet are delivered only once the whole
+// packet checks out, so a multi-sensor burst lands at once or not at all.
+//
+// Negotiation: the link starts as legacy v1 (ant_frame_decoder.h). The Pi sends the
+// v1 command "LINK V2", the bridge answers with a v1 0xF0 frame of type 'L' holding
+// the link version, and both sides use v2 from then on. "LINK V1" (in a v2 packet)
+// switches back; so does a run of LINK_V2_FALLBACK_ERRORS bad packets, which is what
+// a Pi forwarder restarted in v1 mode looks like. The ESP32 → Pi direction stays v1.
+
+#define SERIAL_LINK_V1 1
+#define SERIAL_LINK_V2 2
+#define LINK_V2_VERSION_BYTE 0x02
+#define LINK_V2_HEADER_BYTES 2
+#define LINK_V2_CRC_BYTES 2
+#define LINK_V2_LONG_FORM 0x80
+#define LINK_V2_SHORT_PAYLOAD 8
+#define LINK_V2_LONG_OVERHEAD 3
+#define LINK_V2_COMMAND_FLAG 0x80
+#define LINK_V2_LENGTH_MASK 0x3F
+#define LINK_V2_MAX_PACKET 254  // Decoded; COBS adds at most two code bytes at this size
+#define LINK_V2_MAX_ENCODED (LINK_V2_MAX_PACKET + 2)
+#define LINK_V2_MAX_WIRE_BYTES (LINK_V2_MAX_ENCODED + 1)  // Plus the delimiter
+#define LINK_V2_FALLBACK_ERRORS 8
+#define LINK_FRAME_TYPE 'L'  // Bridge → Pi: link version now in use
+
+struct SerialLinkV2Stats {
+    uint32_t packets;       // Packets accepted
+    uint32_t messages;      // ANT+ messages (and commands) delivered
+    uint32_t crcErrors;
+    uint32_t formatErrors;  // Bad COBS, wrong version, oversize or malformed messages
+    uint32_t drops;         // Packets missing according to the sequence numbers
+    uint32_t reorders;      // Late or duplicated packets (dropped)
+};
+
+// ✅ Same interface as ANTFrameDecoder, so ANTParser can drain the UART ring through
+// either one. Payloads point into the decoder's packet buffer.
+class SerialLinkV2Decoder {
+public:
+    typedef ANTFrameDecoder::FrameHandler FrameHandler;
+
+    SerialLinkV2Decoder();
+    void feed(const uint8_t *data, size_t len, FrameHandler handler, void *context);
+    void reset();  // Drop a partial packet and forget the sequence number
+
+    const SerialLinkV2Stats &getStats() const { return stats; }
+    uint8_t getConsecutiveErrors() const { return consecutiveErrors; }
+
+private:
+    void processPacket(FrameHandler handler, void *context);
+    bool parseMessage(size_t pos, size_t end, ANTFrame &frame) const;
+    void packetError(uint32_t &counter);
+
+    uint8_t encoded[LINK_V2_MAX_ENCODED];
+    uint8_t packet[LINK_V2_MAX_PACKET];
+    size_t encodedLen;
+    bool overflow;        // Packet longer than the buffer: skip to the next delimiter
+    bool haveSequence;
+    uint8_t expectedSequence;
+    uint8_t consecutiveErrors;
+    SerialLinkV2Stats stats;
+};
+
+// ✅ Builds one v2 packet (the Pi side of the link; the host benchmark uses it too)
+class SerialLinkV2Encoder {
+public:
+    SerialLinkV2Encoder();
+    void begin(uint8_t sequence);
+    // False if the message doesn't fit: finish() this packet and start another
+    bool add(uint8_t sync, uint8_t deviceType, const uint8_t *payload, uint8_t len);
+    // COBS + delimiter into `out` (LINK_V2_MAX_WIRE_BYTES); returns the wire length
+    size_t finish(uint8_t *out);
+    uint8_t getMessages() const { return messages; }
+
+private:
+    uint8_t packet[LINK_V2_MAX_PACKET];
+    size_t len;
+    uint8_t messages;
+};
+
+#endif  // SERIAL_LINK_V2_H
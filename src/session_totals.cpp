@@ -0,0 +1,83 @@
+#include "session_totals.h"
+
+void RolloverCounter::update(uint8_t raw, uint32_t expected, uint32_t slack) {
+    if (!primed) {
+        // ✅ First page only sets the baseline
+        last = raw;
+        primed = true;
+        return;
+    }
+
+    uint8_t delta = raw - last;  // ✅ Rollover-safe in 8 bits
+    last = raw;
+    if (delta > expected + slack) {
+        total += expected;  // Counter restarted (trainer power-cycled); go on the estimate
+        return;
+    }
+    // ✅ Whole wraps hidden by missed pages: the multiple of 256 closest to the estimate
+    uint32_t wraps = expected > delta ? (expected - delta + 128) / 256 : 0;
+    total += delta + wraps * 256;
+}
+
+void SessionTotals::reset() {
+    elapsedQuarters.reset();
+    distanceMeters.reset();
+    energyJoules = 0;
+    energyRemainder = 0;
+    resume();
+}
+
+void SessionTotals::resume() {
+    elapsedQuarters.primed = false;
+    distanceMeters.primed = false;
+    lastElapsedMs = 0;
+    lastDistanceMs = 0;
+    lastEvents = 0;
+    lastPower = 0;
+    lastEventMs = 0;
+    lastSource = DeviceType::Unknown;
+}
+
+void SessionTotals::updateElapsed(uint8_t quarterSeconds, uint32_t nowMs) {
+    uint32_t expected = elapsedQuarters.primed ? (nowMs - lastElapsedMs + 125) / 250 : 0;
+    elapsedQuarters.update(quarterSeconds, expected, SESSION_ELAPSED_SLACK);
+    lastElapsedMs = nowMs;
+}
+
+void SessionTotals::updateDistance(uint8_t meters, float speedKmh, uint32_t nowMs) {
+    uint32_t expected = distanceMeters.primed ? (uint32_t)(speedKmh * (nowMs - lastDistanceMs) / 3600.0f + 0.5f) : 0;
+    distanceMeters.update(meters, expected, SESSION_DISTANCE_SLACK + expected / 4);
+    lastDistanceMs = nowMs;
+}
+
+// ✅ Energy = average power of the new events × the time they cover. Dropped pages are
+// covered too (the totals span them), even when fusion gave up on the source for a
+// while; coasting adds nothing (no new events).
+void SessionTotals::updatePower(const FTMSDataStorage &data, uint32_t nowMs) {
+    if (data.power_source == DeviceType::Unknown) return;  // Keep the baseline until it's back
+
+    uint32_t deltaEvents = data.power_event_total - lastEvents;
+    bool restarted = data.power_source != lastSource || deltaEvents > 0x7FFFFFFF;
+    if (!restarted && deltaEvents == 0) return;
+
+    uint32_t deltaPower = data.power_accumulated_total - lastPower;
+    if (!restarted && deltaPower / deltaEvents <= SESSION_MAX_WATTS) {  // Else the sensor restarted its counts
+        uint32_t ms = nowMs - lastEventMs;
+        if (ms / SESSION_MAX_EVENT_MS >= deltaEvents) ms = deltaEvents * SESSION_MAX_EVENT_MS;  // Was coasting
+
+        uint64_t wattMs = (uint64_t)deltaPower * ms / deltaEvents + energyRemainder;
+        energyJoules += wattMs / 1000;
+        energyRemainder = wattMs % 1000;
+    }
+
+    lastSource = data.power_source;
+    lastEvents = data.power_event_total;
+    lastPower = data.power_accumulated_total;
+    lastEventMs = nowMs;
+}
+
+void SessionTotals::apply(FTMSDataStorage &data) const {
+    data.elapsed_time = elapsedQuarters.total / 4;
+    data.distance = distanceMeters.total;
+    data.energy_joules = energyJoules;
+}
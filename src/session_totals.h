@@ -0,0 +1,61 @@
+#ifndef SESSION_TOTALS_H
+#define SESSION_TOTALS_H
+
+#include <Arduino.h>
+#include "ftms_data.h"
+
+#define SESSION_RESUME_MS 300000      // No BLE client for this long ends the session
+#define SESSION_MAX_EVENT_MS 2000     // Longest time one power event may stand for
+#define SESSION_MAX_WATTS 3000        // Average power above this is a counter restart, not a sprint
+#define SESSION_ELAPSED_SLACK 8       // 2 s: the elapsed-time hint comes from our own clock
+#define SESSION_DISTANCE_SLACK 32     // Meters, plus a quarter of the estimate (speed varies)
+// Expended energy as FTMS clients show it: mechanical kJ / 4.184 kJ/kcal / ~24 % gross
+// efficiency, i.e. the usual "1 kJ on the pedals ≈ 1 kcal burnt"
+#define KCAL_PER_KJ 0.996f
+
+// ✅ Extends an 8-bit rolling counter (FE elapsed time, distance) into a 32-bit total.
+// `expected` is the increase the time since the previous page suggests: it tells how
+// many wraps happened while pages were missed. A count further ahead than
+// expected + `slack` means the trainer restarted it; the estimate is added instead.
+struct RolloverCounter {
+    uint32_t total;
+    uint8_t last;
+    bool primed;
+
+    RolloverCounter() { reset(); }
+    void reset() {
+        total = 0;
+        last = 0;
+        primed = false;
+    }
+    void update(uint8_t raw, uint32_t expected, uint32_t slack);
+};
+
+// ✅ Ride totals for FTMS Indoor Bike Data: elapsed time and distance from FE page 0x10,
+// energy from the power totals of whichever source fusion picked. O(1) per page.
+// resume() forgets the baselines but keeps the totals (sensor or data reset, a short
+// BLE reconnect); reset() starts a new session.
+struct SessionTotals {
+    RolloverCounter elapsedQuarters;  // 0.25 s, wraps every 64 s
+    RolloverCounter distanceMeters;   // Wraps every 256 m
+    uint32_t lastElapsedMs;
+    uint32_t lastDistanceMs;
+
+    uint32_t energyJoules;
+    uint32_t energyRemainder;  // W·ms not yet a whole joule
+    uint32_t lastEvents;
+    uint32_t lastPower;
+    uint32_t lastEventMs;
+    DeviceType lastSource;
+
+    SessionTotals() { reset(); }
+    void reset();
+    void resume();
+
+    void updateElapsed(uint8_t quarterSeconds, uint32_t nowMs);
+    void updateDistance(uint8_t meters, float speedKmh, uint32_t nowMs);
+    void updatePower(const FTMSDataStorage &data, uint32_t nowMs);  // After fusion picked the source
+    void apply(FTMSDataStorage &data) const;
+};
+
+#endif  // SESSION_TOTALS_H
@@ -0,0 +1,72 @@
+#include "speed_cadence.h"
+
+#define MAX_PLAUSIBLE_RPM 3000.0f  // Wheel at ~200 km/h; anything above is a counter glitch
+
+void RevolutionRate::reset() {
+    rpm = 0;
+    totalRevolutions = 0;
+    lastEventMs = 0;
+    lastEventTime = 0;
+    lastRevolutions = 0;
+    primed = false;
+}
+
+bool RevolutionRate::update(uint16_t eventTime, uint16_t revolutions, uint32_t nowMs) {
+    if (!primed) {
+        lastEventTime = eventTime;
+        lastRevolutions = revolutions;
+        lastEventMs = nowMs;
+        primed = true;
+        return false;
+    }
+
+    uint16_t deltaTime = eventTime - lastEventTime;        // ✅ Rollover-safe in 16 bits
+    uint16_t deltaRevs = revolutions - lastRevolutions;
+
+    if (deltaTime == 0) {
+        // ✅ Same event repeated: still moving until the stop timeout says otherwise
+        if (nowMs - lastEventMs > REVOLUTION_STOP_MS) rpm = 0;
+        return false;
+    }
+
+    float rate = deltaRevs * 1024.0f * 60.0f / deltaTime;
+    if (rate <= MAX_PLAUSIBLE_RPM) {
+        rpm = rate;
+        totalRevolutions += deltaRevs;
+    }
+
+    lastEventTime = eventTime;
+    lastRevolutions = revolutions;
+    lastEventMs = nowMs;
+    return true;
+}
+
+void RevolutionSynth::reset() {
+    revolutions = 0;
+    eventTimeMs = 0;
+    fraction = 0;
+    lastMs = 0;
+    primed = false;
+}
+
+void RevolutionSynth::advance(float rpm, uint32_t nowMs) {
+    if (!primed) {
+        lastMs = nowMs;
+        eventTimeMs = nowMs;
+        primed = true;
+        return;
+    }
+
+    uint32_t elapsedMs = nowMs - lastMs;
+    lastMs = nowMs;
+    if (rpm <= 0) return;  // ✅ Stopped: counters and event time hold, like a real sensor
+
+    fraction += rpm * elapsedMs / 60000.0f;
+    if (fraction < 1.0f) return;
+
+    uint32_t whole = (uint32_t)fraction;
+    fraction -= whole;
+    revolutions += whole;
+    // Back-date the event to when the last whole revolution completed
+    eventTimeMs = nowMs - (uint32_t)(fraction * 60000.0f / rpm);
+}
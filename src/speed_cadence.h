@@ -0,0 +1,60 @@
+#ifndef SPEED_CADENCE_H
+#define SPEED_CADENCE_H
+
+#include <Arduino.h>
+
+#define REVOLUTION_STOP_MS 3000          // No new revolution event for this long: wheel/crank stopped
+#define DEFAULT_WHEEL_CIRCUMFERENCE_MM 2096  // 700x23c
+#define MIN_WHEEL_CIRCUMFERENCE_MM 1000
+#define MAX_WHEEL_CIRCUMFERENCE_MM 3000
+
+// ✅ Revolutions per minute from the (event time, cumulative revolutions) pairs that
+// ANT+ bike speed (123), cadence (122) and combined (121) sensors broadcast. Both
+// counters are 16-bit and roll over (event time every 64 s at 1/1024 s), so deltas
+// are taken in 16 bits. Sensors repeat the last event at ~4 Hz while nothing moves;
+// after REVOLUTION_STOP_MS without a new event the rate drops to zero.
+struct RevolutionRate {
+    float rpm;
+    uint32_t totalRevolutions;  // Rollover-extended, for distance
+    uint32_t lastEventMs;
+    uint16_t lastEventTime;     // 1/1024 s
+    uint16_t lastRevolutions;
+    bool primed;
+
+    RevolutionRate() { reset(); }
+    void reset();
+
+    // Returns true if the page carried a new revolution event
+    bool update(uint16_t eventTime, uint16_t revolutions, uint32_t nowMs);
+};
+
+// Wheel RPM → km/h for the given circumference
+inline float wheelSpeedKmh(float rpm, uint16_t circumferenceMm) {
+    return rpm * circumferenceMm * 60.0f / 1000000.0f;
+}
+
+inline float wheelRpm(float speedKmh, uint16_t circumferenceMm) {
+    return speedKmh * 1000000.0f / (circumferenceMm * 60.0f);
+}
+
+// ✅ The inverse of RevolutionRate: turns a fused RPM back into the (cumulative
+// revolutions, last event time) pair that BLE CSC and Cycling Power clients expect.
+// Call advance() once per notify with the current rate; the event time is that of
+// the last whole revolution, in 1/`ticksPerSecond` s (1024 for CSC crank/wheel and
+// CPS crank, 2048 for CPS wheel).
+struct RevolutionSynth {
+    uint32_t revolutions;
+    uint32_t eventTimeMs;  // Time of the last whole revolution
+    float fraction;        // Part of the next revolution already turned
+    uint32_t lastMs;
+    bool primed;
+
+    RevolutionSynth() { reset(); }
+    void reset();
+    void advance(float rpm, uint32_t nowMs);
+    uint16_t eventTime(uint16_t ticksPerSecond) const {
+        return (uint16_t)((uint64_t)eventTimeMs * ticksPerSecond / 1000);
+    }
+};
+
+#endif  // SPEED_CADENCE_H
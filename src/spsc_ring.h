@@ -0,0 +1,58 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// ✅ Lock-free single-producer / single-consumer byte ring.
+// The producer fills contiguous free space in place (getWritable + commit) and the
+// consumer decodes contiguous readable space in place (getReadable + consume), so bytes
+// are never copied between the UART driver and the frame decoder.
+template <size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    // Producer side
+    size_t getWritable(uint8_t **span) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        size_t free = N - (h - t);
+        size_t toEnd = N - (h & (N - 1));
+        *span = buffer + (h & (N - 1));
+        return free < toEnd ? free : toEnd;
+    }
+
+    void commit(size_t n) {
+        head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Consumer side
+    size_t getReadable(const uint8_t **span) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        size_t used = h - t;
+        size_t toEnd = N - (t & (N - 1));
+        *span = buffer + (t & (N - 1));
+        return used < toEnd ? used : toEnd;
+    }
+
+    void consume(size_t n) {
+        tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    }
+
+    // Either side (approximate while the other side is running)
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    uint8_t buffer[N];
+    std::atomic<uint32_t> head;  // Total bytes ever written (wraps at 2^32, masked on use)
+    std::atomic<uint32_t> tail;  // Total bytes ever consumed
+};
+
+#endif  // SPSC_RING_H
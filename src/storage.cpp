@@ -0,0 +1,56 @@
+#include "storage.h"
+#include <LittleFS.h>
+#include <atomic>
+#include "logger.h"
+
+enum class MountState : uint8_t { Unmounted, Mounting, Mounted, Failed };
+
+static std::atomic<MountState> state(MountState::Unmounted);
+
+bool storage_mount() {
+    MountState expected = MountState::Unmounted;
+    if (state.compare_exchange_strong(expected, MountState::Mounting)) {
+        bool ok = LittleFS.begin(true);  // Formats an empty partition on first use
+        if (ok) {
+            LOGF("[INFO] LittleFS %u/%u KB used",
+                 (unsigned)(LittleFS.usedBytes() / 1024), (unsigned)(LittleFS.totalBytes() / 1024));
+        } else {
+            LOG("[ERROR] LittleFS mount failed");
+        }
+        state = ok ? MountState::Mounted : MountState::Failed;
+        return ok;
+    }
+    while (state == MountState::Mounting) vTaskDelay(pdMS_TO_TICKS(STORAGE_MOUNT_POLL_MS));
+    return state == MountState::Mounted;
+}
+
+bool storage_is_mounted() {
+    return state == MountState::Mounted;
+}
+
+void storage_numbered_path(char *path, size_t size, const char *dir, const char *extension, uint32_t seq) {
+    snprintf(path, size, "%s/%08u%s", dir, (unsigned)seq, extension);
+}
+
+uint32_t storage_prune(const char *dir, const char *extension, uint32_t keepFrom) {
+    uint32_t oldest = UINT32_MAX;
+    uint32_t newest = 0;
+    File root = LittleFS.open(dir);
+    if (!root || !root.isDirectory()) return 0;
+    for (File file = root.openNextFile(); file; file = root.openNextFile()) {
+        uint32_t seq = strtoul(file.name(), nullptr, 10);
+        file.close();
+        if (seq < oldest) oldest = seq;
+        if (seq > newest) newest = seq;
+    }
+    root.close();
+
+    // ✅ Numbers are contiguous: the recorders always delete from the old end. Not while
+    // iterating the directory, which removing would disturb.
+    char path[32];
+    for (uint32_t seq = oldest; seq < keepFrom && seq <= newest; seq++) {
+        storage_numbered_path(path, sizeof(path), dir, extension, seq);
+        LittleFS.remove(path);
+    }
+    return newest;
+}
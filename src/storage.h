@@ -0,0 +1,20 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <Arduino.h>
+
+#define STORAGE_MOUNT_POLL_MS 50
+
+// ✅ LittleFS is shared by the capture and ride recorders. Whichever task asks first
+// mounts it (formatting an empty partition, which takes seconds); the others wait for
+// the outcome. Call from the recorders' own tasks, never from setup().
+bool storage_mount();
+bool storage_is_mounted();
+
+// ✅ Numbered files `<dir>/<%08u><extension>`, as the recorders keep them: writes the
+// path of number `seq`, and deletes every file numbered below `keepFrom`. Returns the
+// newest number (0 if there are none).
+void storage_numbered_path(char *path, size_t size, const char *dir, const char *extension, uint32_t seq);
+uint32_t storage_prune(const char *dir, const char *extension, uint32_t keepFrom);
+
+#endif  // STORAGE_H
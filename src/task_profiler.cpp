@@ -0,0 +1,167 @@
+#include "task_profiler.h"
+#include "logger.h"
+
+// ✅ uxTaskGetSystemState() needs the trace facility; CPU time also needs run-time
+// stats. Without them only the stacks of well-known tasks can be reported.
+#if configUSE_TRACE_FACILITY
+    #define PROFILER_SYSTEM_STATE 1
+#else
+    #define PROFILER_SYSTEM_STATE 0
+#endif
+#if PROFILER_SYSTEM_STATE && configGENERATE_RUN_TIME_STATS
+    #define PROFILER_RUN_TIME 1
+#else
+    #define PROFILER_RUN_TIME 0
+#endif
+
+static uint32_t intervalMs = TASK_PROFILER_INTERVAL_MS;
+static uint32_t lastSampleMs = 0;
+
+#ifdef configRUN_TIME_COUNTER_TYPE
+typedef configRUN_TIME_COUNTER_TYPE RunTimeCounter;
+#else
+typedef uint32_t RunTimeCounter;
+#endif
+
+#if PROFILER_SYSTEM_STATE
+static TaskStatus_t tasks[TASK_PROFILER_MAX_TASKS];  // loop() only
+#endif
+
+#if PROFILER_RUN_TIME
+struct PreviousRunTime {
+    UBaseType_t taskNumber;
+    RunTimeCounter runTime;
+};
+
+static PreviousRunTime previous[TASK_PROFILER_MAX_TASKS];
+static UBaseType_t previousCount = 0;
+static RunTimeCounter previousTotal = 0;
+
+static bool previousRunTime(UBaseType_t taskNumber, RunTimeCounter *runTime) {
+    for (UBaseType_t i = 0; i < previousCount; i++) {
+        if (previous[i].taskNumber == taskNumber) {
+            *runTime = previous[i].runTime;
+            return true;
+        }
+    }
+    return false;  // Task created since the last snapshot
+}
+#endif
+
+#if PROFILER_SYSTEM_STATE
+static char stateLetter(eTaskState state) {
+    switch (state) {
+        case eRunning: return 'X';
+        case eReady: return 'R';
+        case eBlocked: return 'B';
+        case eSuspended: return 'S';
+        case eDeleted: return 'D';
+        default: return '?';
+    }
+}
+#else
+// Names the Arduino core, NimBLE, WiFi and this firmware give their tasks
+static const char *const KNOWN_TASKS[] = {
+    "loopTask", "ant_parse", "ble_notify", "log_drain", "nimble_host", "async_tcp",
+    "arduino_events", "uart_event_task", "esp_timer", "wifi", "tiT", "sys_evt", "IDLE0", "IDLE1"
+};
+#endif
+
+bool profiler_set_interval(uint32_t ms) {
+    if (ms != 0 && ms < TASK_PROFILER_MIN_INTERVAL_MS) {
+        LOGF("[ERROR] Invalid profiler interval: %u ms", ms);
+        return false;
+    }
+    intervalMs = ms;
+    lastSampleMs = millis() - ms;  // First snapshot right away; it only sets the CPU baseline
+#if PROFILER_RUN_TIME
+    previousCount = 0;
+    previousTotal = 0;
+#endif
+    LOGF("[INFO] Task profiler: %s%u ms", ms ? "every " : "off, ", ms);
+    return true;
+}
+
+uint32_t profiler_get_interval() {
+    return intervalMs;
+}
+
+bool profiler_due(uint32_t nowMs) {
+    if (intervalMs == 0 || nowMs - lastSampleMs < intervalMs) return false;
+    lastSampleMs = nowMs;
+    return true;
+}
+
+size_t profiler_sample(char *out, size_t size) {
+    size_t n = 0;
+    auto append = [&](const char *format, auto... args) {
+        if (n >= size) return;
+        int written = snprintf(out + n, size - n, format, args...);
+        if (written > 0) n += written;
+    };
+
+    append("{\"type\":\"tasks\",\"interval_ms\":%u,\"cores\":%d,\"run_time_stats\":%s,\"tasks\":[",
+           intervalMs, portNUM_PROCESSORS, PROFILER_RUN_TIME ? "true" : "false");
+
+#if PROFILER_SYSTEM_STATE
+    RunTimeCounter total = 0;
+    UBaseType_t count = uxTaskGetSystemState(tasks, TASK_PROFILER_MAX_TASKS, &total);
+    if (count == 0) {
+        LOGF("[WARN] Task profiler: more than %d tasks, raise TASK_PROFILER_MAX_TASKS", TASK_PROFILER_MAX_TASKS);
+    }
+    #if PROFILER_RUN_TIME
+    RunTimeCounter elapsed = total - previousTotal;  // Run-time clock ticks; each core counts its own
+    #endif
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t &task = tasks[i];
+        append("%s{\"name\":\"%s\",\"cpu\":", i ? "," : "", task.pcTaskName);
+
+    #if PROFILER_RUN_TIME
+        RunTimeCounter before;
+        if (previousTotal != 0 && elapsed != 0 && previousRunTime(task.xTaskNumber, &before)) {
+            append("%.1f", (task.ulRunTimeCounter - before) * 100.0f / elapsed);
+        } else {
+            append("null");  // First snapshot, or a new task
+        }
+    #else
+        append("null");
+    #endif
+
+    #if configTASKLIST_INCLUDE_COREID
+        int core = task.xCoreID < portNUM_PROCESSORS ? (int)task.xCoreID : -1;  // -1: not pinned
+    #else
+        int core = -1;
+    #endif
+        append(",\"stack_free\":%u,\"prio\":%u,\"core\":%d,\"state\":\"%c\"}",
+               (unsigned)task.usStackHighWaterMark, (unsigned)task.uxCurrentPriority, core,
+               stateLetter(task.eCurrentState));
+    }
+
+    #if PROFILER_RUN_TIME
+    // ✅ Baseline for the next snapshot's deltas
+    for (UBaseType_t i = 0; i < count; i++) {
+        previous[i].taskNumber = tasks[i].xTaskNumber;
+        previous[i].runTime = tasks[i].ulRunTimeCounter;
+    }
+    previousCount = count;
+    previousTotal = total;
+    #endif
+#else
+    bool first = true;
+    for (const char *name : KNOWN_TASKS) {
+        TaskHandle_t handle = xTaskGetHandle(name);
+        if (!handle) continue;
+        append("%s{\"name\":\"%s\",\"cpu\":null,\"stack_free\":%u}", first ? "" : ",", name,
+               (unsigned)uxTaskGetStackHighWaterMark(handle));
+        first = false;
+    }
+#endif
+    append("]}");
+
+    if (n >= size) {
+        if (size) out[0] = '\0';
+        return 0;
+    }
+    return n;
+}
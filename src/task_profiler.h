@@ -0,0 +1,27 @@
+#ifndef TASK_PROFILER_H
+#define TASK_PROFILER_H
+
+#include <Arduino.h>
+
+// ✅ Profiling mode: every interval, a snapshot of all FreeRTOS tasks with their CPU
+// share since the previous snapshot and their stack high-water mark, as JSON for /ws.
+// Off unless TASK_PROFILER_INTERVAL_MS is set at build time or PROFILE <ms> is sent.
+#ifndef TASK_PROFILER_INTERVAL_MS
+    #define TASK_PROFILER_INTERVAL_MS 0  // 0 = off at boot
+#endif
+
+#define TASK_PROFILER_MIN_INTERVAL_MS 500
+#define TASK_PROFILER_MAX_TASKS 32  // NimBLE, WiFi, lwIP, AsyncTCP, esp_timer, ours, idle...
+#define TASK_PROFILER_JSON_SIZE 3072
+
+bool profiler_set_interval(uint32_t intervalMs);  // 0 turns profiling off
+uint32_t profiler_get_interval();
+bool profiler_due(uint32_t nowMs);  // ✅ True once per interval while profiling is on
+
+// {"type":"tasks","interval_ms":..,"cores":..,"run_time_stats":true,"tasks":[{"name":..,
+// "cpu":12.5,"stack_free":1234,"prio":5,"core":1,"state":"B"},...]}. `cpu` is the share
+// of one core since the previous snapshot (null without run-time stats), `stack_free`
+// the least free stack ever seen, in bytes. Returns 0 if the JSON didn't fit.
+size_t profiler_sample(char *out, size_t size);
+
+#endif  // TASK_PROFILER_H
@@ -0,0 +1,169 @@
+#include "telemetry_stream.h"
+#include "websocket_manager.h"
+#include "logger.h"
+
+struct TelemetryEvent {
+    uint32_t clientId;
+    bool subscribed;
+};
+
+// ✅ Only the telemetry task touches these, so no locking
+struct TelemetryClient {
+    uint32_t id;  // 0 = free slot
+    TelemetrySample backlog[TELEMETRY_CLIENT_BACKLOG];
+    uint8_t head;
+    uint8_t count;
+    uint32_t droppedSinceFrame;
+};
+
+static QueueHandle_t sampleQueue = nullptr;
+static QueueHandle_t eventQueue = nullptr;
+static TelemetryClient clients[TELEMETRY_MAX_CLIENTS];
+static TelemetryStats stats;
+
+static uint8_t *putUInt16(uint8_t *p, uint16_t value) {
+    p[0] = value & 0xFF;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static uint8_t *putUInt32(uint8_t *p, uint32_t value) {
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = value >> 24;
+    return p + 4;
+}
+
+static void applyEvent(const TelemetryEvent &event) {
+    for (TelemetryClient &client : clients) {
+        if (client.id == event.clientId) client.id = 0;  // Resubscribing starts afresh
+    }
+    if (!event.subscribed) return;
+
+    for (TelemetryClient &client : clients) {
+        if (client.id != 0) continue;
+        client.id = event.clientId;
+        client.head = 0;
+        client.count = 0;
+        client.droppedSinceFrame = 0;
+        return;
+    }
+    LOGF("[WARN] Telemetry: no slot for WebSocket client %u", event.clientId);
+}
+
+// ✅ Oldest-first drop: a client that can't keep up sees the newest samples
+static void enqueue(TelemetryClient &client, const TelemetrySample &sample) {
+    if (client.count == TELEMETRY_CLIENT_BACKLOG) {
+        client.head = (client.head + 1) % TELEMETRY_CLIENT_BACKLOG;
+        client.count--;
+        client.droppedSinceFrame++;
+        stats.dropped++;
+    }
+    client.backlog[(client.head + client.count) % TELEMETRY_CLIENT_BACKLOG] = sample;
+    client.count++;
+}
+
+// Returns true if samples are still waiting for this client
+static bool flush(TelemetryClient &client) {
+    if (client.count == 0) return false;
+
+    // ✅ By id: the server looks the client up under its lock. A client that's gone
+    // looks blocked until its disconnect event frees the slot.
+    if (!ws.availableForWrite(client.id)) {
+        stats.deferred++;
+        return true;
+    }
+
+    static uint8_t frame[TELEMETRY_HEADER_BYTES + TELEMETRY_CLIENT_BACKLOG * TELEMETRY_SAMPLE_BYTES];
+    uint8_t *p = frame;
+    *p++ = TELEMETRY_FRAME_TYPE;
+    *p++ = TELEMETRY_VERSION;
+    *p++ = client.count;
+    *p++ = client.droppedSinceFrame > 0xFF ? 0xFF : client.droppedSinceFrame;
+    for (uint8_t i = 0; i < client.count; i++) {
+        const TelemetrySample &s = client.backlog[(client.head + i) % TELEMETRY_CLIENT_BACKLOG];
+        p = putUInt32(p, s.timeMs);
+        p = putUInt16(p, s.power);
+        p = putUInt16(p, s.speed);
+        *p++ = s.cadence;
+        *p++ = s.heartRate;
+        p = putUInt16(p, s.rxAgeMs);
+    }
+
+    if (!ws.binary(client.id, frame, p - frame)) {
+        stats.deferred++;
+        return true;  // Queue filled up in the meantime; keep the backlog
+    }
+    client.head = 0;
+    client.count = 0;
+    client.droppedSinceFrame = 0;
+    stats.frames++;
+    return false;
+}
+
+static void telemetryTask(void *arg) {
+    bool backlogged = false;
+
+    for (;;) {
+        TelemetrySample sample;
+        bool fresh = xQueueReceive(sampleQueue, &sample,
+                                   backlogged ? pdMS_TO_TICKS(TELEMETRY_RETRY_MS) : portMAX_DELAY) == pdTRUE;
+
+        TelemetryEvent event;
+        while (xQueueReceive(eventQueue, &event, 0) == pdTRUE) applyEvent(event);
+
+        // ✅ Drain everything queued before sending, so a burst becomes one frame
+        while (fresh) {
+            for (TelemetryClient &client : clients) {
+                if (client.id) enqueue(client, sample);
+            }
+            fresh = xQueueReceive(sampleQueue, &sample, 0) == pdTRUE;
+        }
+
+        backlogged = false;
+        for (TelemetryClient &client : clients) {
+            if (client.id && flush(client)) backlogged = true;
+        }
+    }
+}
+
+void telemetry_start() {
+    if (sampleQueue) return;
+    sampleQueue = xQueueCreate(TELEMETRY_QUEUE_LENGTH, sizeof(TelemetrySample));
+    eventQueue = xQueueCreate(TELEMETRY_EVENT_QUEUE_LENGTH, sizeof(TelemetryEvent));
+    xTaskCreate(telemetryTask, "telemetry", TELEMETRY_STACK, nullptr, TELEMETRY_PRIORITY, nullptr);
+    LOG("[INFO] Telemetry stream on /ws started");
+}
+
+void telemetry_publish(const FTMSDataStorage &data, uint32_t nowMs, uint16_t rxAgeMs) {
+    if (!sampleQueue) return;
+
+    TelemetrySample sample;
+    sample.timeMs = nowMs;
+    sample.power = data.instantaneous_power;  // Fused power; `power` is the unused legacy field
+    sample.speed = (uint16_t)(data.speed * 100.0f + 0.5f);
+    sample.cadence = data.cadence;
+    sample.heartRate = data.heart_rate;
+    sample.rxAgeMs = rxAgeMs;
+
+    if (xQueueSend(sampleQueue, &sample, 0) == pdTRUE) {
+        stats.samples++;
+    } else {
+        stats.queueDrops++;
+    }
+}
+
+void telemetry_client_subscribe(uint32_t clientId, bool subscribed) {
+    TelemetryEvent event = { clientId, subscribed };
+    if (eventQueue) xQueueSend(eventQueue, &event, 0);
+}
+
+const TelemetryStats &telemetry_get_stats() {
+    return stats;
+}
+
+void telemetry_log_stats() {
+    LOGF("[TLM] samples: %u, frames: %u, deferred: %u, dropped: %u, queue drops: %u",
+         stats.samples, stats.frames, stats.deferred, stats.dropped, stats.queueDrops);
+}
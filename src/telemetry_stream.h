@@ -0,0 +1,62 @@
+#ifndef TELEMETRY_STREAM_H
+#define TELEMETRY_STREAM_H
+
+#include <Arduino.h>
+#include "ftms_data.h"
+
+// ✅ Live binary telemetry on /ws: every fused sample the notify task publishes goes
+// as compact binary frames to each WebSocket client that sent the text command
+// "TELEMETRY ON" (until "TELEMETRY OFF" or it disconnects); the Pi's ingest client
+// never asks, so it gets none. Each client has its own backlog;
+// while its AsyncTCP queue is full, samples pile up there and go out later as one
+// batch, and a full backlog drops its oldest sample. The notify task only does a
+// non-blocking queue send, so a slow browser tab can never hold up BLE. Sends go
+// through the server by client id, never through an AsyncWebSocketClient pointer the
+// async_tcp task may free meanwhile.
+//
+// Frame: 'T' | version | count | dropped | count × sample, where `dropped` is how many
+// samples this client lost since its previous frame (saturating) and a sample is
+//   timeMs (u32) | power W (u16) | speed 0.01 km/h (u16) | cadence rpm (u8) |
+//   heart rate bpm (u8) | rxAgeMs (u16, ANT+ bytes → sample; 0xFFFF for keepalives)
+// With no BLE central connected, fresh samples still stream at the notify rate.
+// All little-endian.
+
+#define TELEMETRY_FRAME_TYPE 'T'
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_HEADER_BYTES 4
+#define TELEMETRY_SAMPLE_BYTES 12
+
+#define TELEMETRY_MAX_CLIENTS 4
+#define TELEMETRY_CLIENT_BACKLOG 32  // Samples held per client while it can't take more
+#define TELEMETRY_QUEUE_LENGTH 16    // Notify task → telemetry task
+#define TELEMETRY_EVENT_QUEUE_LENGTH 8
+#define TELEMETRY_RETRY_MS 50        // Re-check blocked clients this often
+#define TELEMETRY_PRIORITY 1
+#define TELEMETRY_STACK 4096
+
+struct TelemetrySample {
+    uint32_t timeMs;
+    uint16_t power;
+    uint16_t speed;  // 0.01 km/h
+    uint8_t cadence;
+    uint8_t heartRate;
+    uint16_t rxAgeMs;
+};
+
+struct TelemetryStats {
+    uint32_t samples;     // Accepted from the notify task
+    uint32_t queueDrops;  // Telemetry task behind: dropped before reaching any client
+    uint32_t frames;      // Binary frames sent to clients
+    uint32_t deferred;    // Flushes skipped because the client's queue was full
+    uint32_t dropped;     // Oldest samples dropped from full client backlogs
+};
+
+void telemetry_start();
+// ✅ Pipeline sample listener (notify task); never blocks
+void telemetry_publish(const FTMSDataStorage &data, uint32_t nowMs, uint16_t rxAgeMs);
+// From WebSocket commands and events; a disconnect unsubscribes
+void telemetry_client_subscribe(uint32_t clientId, bool subscribed);
+const TelemetryStats &telemetry_get_stats();
+void telemetry_log_stats();
+
+#endif  // TELEMETRY_STREAM_H
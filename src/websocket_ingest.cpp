@@ -0,0 +1,64 @@
+#include "websocket_ingest.h"
+
+WebSocketIngest wsIngest;
+
+WebSocketIngest::WebSocketIngest()
+    : dataCallback(nullptr), oldestPendingUs(0), source(0), sourceLastMs(0), hasSource(false), dropping(false) {
+    stats = {};
+}
+
+void WebSocketIngest::setDataCallback(void (*callback)()) {
+    dataCallback = callback;
+}
+
+void WebSocketIngest::disconnected(uint32_t client) {
+    if (hasSource && source == client) hasSource = false;
+}
+
+bool WebSocketIngest::writeChunk(uint32_t client, const uint8_t *data, size_t len, uint64_t index,
+                                 uint64_t frameLen, bool finalFrame) {
+    // ✅ One source at a time: another client's chunks would land inside its frames
+    uint32_t nowMs = millis();
+    if (!hasSource || (client != source && nowMs - sourceLastMs >= WS_INGEST_SOURCE_IDLE_MS)) {
+        hasSource = true;
+        source = client;
+        dropping = false;
+    } else if (client != source) {
+        stats.rejected++;
+        return false;
+    }
+    sourceLastMs = nowMs;
+
+    // ✅ Whole frames only: half a batch would cost the decoder a resync. Only the
+    // parse task drains the ring meanwhile, so the room reserved here stays free.
+    size_t fill = ring.size();
+    size_t room = ring.capacity() - fill;
+    if (!dropping && ((index == 0 && frameLen > room) || len > room)) {
+        stats.overruns++;
+        dropping = true;
+    }
+    bool accepted = !dropping;
+    bool messageEnd = finalFrame && index + len >= frameLen;
+    if (messageEnd) dropping = false;
+    if (!accepted) return false;
+    if (len == 0) return true;
+
+    if (fill == 0) oldestPendingUs = micros();
+    while (len > 0) {
+        uint8_t *span;
+        size_t space = ring.getWritable(&span);  // At most two spans when the ring wraps
+        size_t n = space < len ? space : len;
+        memcpy(span, data, n);
+        ring.commit(n);
+        data += n;
+        len -= n;
+        stats.bytesIn += n;
+    }
+    if (messageEnd) stats.messages++;
+
+    fill = ring.size();
+    if (fill > stats.highWater) stats.highWater = fill;
+
+    if (dataCallback) dataCallback();
+    return true;
+}
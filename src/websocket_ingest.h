@@ -0,0 +1,64 @@
+#ifndef WEBSOCKET_INGEST_H
+#define WEBSOCKET_INGEST_H
+
+#include <Arduino.h>
+#include "spsc_ring.h"
+
+#ifndef WS_INGEST_RING_SIZE
+    #define WS_INGEST_RING_SIZE 8192  // Must be a power of two; holds several full batches
+#endif
+#define WS_INGEST_SOURCE_IDLE_MS 5000  // A silent source gives way to another client
+
+typedef SpscRing<WS_INGEST_RING_SIZE> WebSocketRing;
+
+struct WebSocketIngestStats {
+    uint32_t messages;  // Binary WebSocket messages accepted
+    uint32_t bytesIn;
+    uint32_t overruns;  // Messages dropped because a frame of theirs didn't fit the ring
+    uint32_t rejected;  // Chunks from a client other than the current source
+    uint32_t highWater;
+};
+
+// ✅ ANT+ frames over WiFi: the Pi forwarder sends binary /ws messages holding any
+// number of frames in the serial layout (sync | deviceType | length | payload | xor).
+// writeChunk() runs on the AsyncTCP task, once per data callback: a TCP-sized chunk
+// of a WebSocket frame. Room for the whole frame is reserved with its first chunk; if
+// it isn't there, every remaining chunk of that message is dropped, so a batch sent as
+// one frame (as the Pi forwarder does) lands whole or not at all. Of a message split
+// into several frames, the ones before a dropped frame are kept; the decoder resyncs.
+// Frames may span messages, so one client is the source at a time: the first to send,
+// until it disconnects or stays silent for WS_INGEST_SOURCE_IDLE_MS. Binary from any
+// other client is rejected rather than interleaved into the ring.
+// The parsing task drains the ring through its own frame decoder into the same
+// dispatch and fusion as the UART, via ANTParser::readWebSocket(). No per-frame
+// allocation.
+class WebSocketIngest {
+public:
+    WebSocketIngest();
+    // ✅ `len` bytes at `index` of a frame of `frameLen` bytes from `client`; `finalFrame`
+    // if that frame ends its message (AwsFrameInfo index, len, final). False if dropped
+    // or rejected. Single producer.
+    bool writeChunk(uint32_t client, const uint8_t *data, size_t len, uint64_t index, uint64_t frameLen,
+                    bool finalFrame);
+    bool write(const uint8_t *data, size_t len) { return writeChunk(0, data, len, 0, len, true); }  // Whole message
+    void disconnected(uint32_t client);  // Frees the source slot if it was `client`
+    void setDataCallback(void (*callback)());  // ✅ Called after new bytes land in the ring
+
+    WebSocketRing &getRing() { return ring; }
+    const WebSocketIngestStats &getStats() const { return stats; }
+    uint32_t getOldestPendingMicros() const { return oldestPendingUs; }
+
+private:
+    WebSocketRing ring;
+    WebSocketIngestStats stats;
+    void (*dataCallback)();
+    volatile uint32_t oldestPendingUs;
+    uint32_t source;  // Client the ring is taking frames from
+    uint32_t sourceLastMs;
+    bool hasSource;
+    bool dropping;  // Rest of the source's current message is being discarded
+};
+
+extern WebSocketIngest wsIngest;
+
+#endif  // WEBSOCKET_INGEST_H
@@ -1,22 +1,165 @@
 #include "websocket_manager.h"
+#include <LittleFS.h>
+#include <memory>
+#include <new>
+#include "capture_recorder.h"
+#include "fit_export.h"
+#include "ride_recorder.h"
 #include "logger.h"
+#include "metrics.h"
+#include "task_profiler.h"
+#include "telemetry_stream.h"
+#include "websocket_ingest.h"
+
+#define WS_COMMAND_MAX 32
+#define CAPTURE_LIST_JSON_SIZE 1024
+#define RIDE_LIST_JSON_SIZE 2048
 
 AsyncWebServer server(80);
 AsyncWebSocket ws("/ws");
 
-void onWebSocketMessage(void *arg, uint8_t *data, size_t len) {
-    LOGF("Received WebSocket Data: %s\n", data);
-    // Parse and use ANT+ data here
+// ✅ Binary messages are batches of ANT+ frames (serial layout), in any fragmentation.
+// Text frames are commands:
+//   METRICS          binary metrics snapshot to this client (layout in metrics.h)
+//   PROFILE <ms>     per-task CPU/stack snapshots to all clients every <ms>
+//   PROFILE OFF
+//   TELEMETRY ON     live binary telemetry to this client (layout in telemetry_stream.h)
+//   TELEMETRY OFF
+void onWebSocketMessage(AsyncWebSocketClient *client, void *arg, uint8_t *data, size_t len) {
+    AwsFrameInfo *info = (AwsFrameInfo *)arg;
+    if (info->opcode == WS_BINARY || info->message_opcode == WS_BINARY) {
+        // ✅ Copied into the ring (whole frames or nothing); the parse task decodes it
+        wsIngest.writeChunk(client->id(), data, len, info->index, info->len, info->final);
+        return;
+    }
+    if (!info->final || info->index != 0 || info->len != len || info->opcode != WS_TEXT) {
+        return;  // Commands are single-frame text messages
+    }
+    if (len >= WS_COMMAND_MAX) {
+        LOGF("[WARN] WebSocket command too long (%u bytes)", (unsigned)len);
+        return;
+    }
+
+    char command[WS_COMMAND_MAX];
+    memcpy(command, data, len);
+    command[len] = '\0';
+
+    unsigned int intervalMs;
+    if (strcmp(command, "METRICS") == 0) {
+        static uint8_t snapshot[METRICS_BINARY_SIZE];  // async_tcp task only
+        size_t n = metrics.writeBinary(snapshot, sizeof(snapshot), millis());
+        client->binary(snapshot, n);
+    } else if (strcmp(command, "TELEMETRY ON") == 0) {
+        telemetry_client_subscribe(client->id(), true);
+    } else if (strcmp(command, "TELEMETRY OFF") == 0) {
+        telemetry_client_subscribe(client->id(), false);
+    } else if (strcmp(command, "PROFILE OFF") == 0) {
+        profiler_set_interval(0);
+    } else if (sscanf(command, "PROFILE %u", &intervalMs) == 1) {
+        profiler_set_interval(intervalMs);
+    } else {
+        LOGF("[WARN] Unknown WebSocket command: %s", command);
+    }
+}
+
+void publishMetricsSnapshot() {
+    ws.cleanupClients();  // ✅ Free clients that went away without closing
+    if (ws.count() == 0) return;
+
+    static char json[METRICS_JSON_SIZE];  // loop() only
+    size_t n = metrics.writeJson(json, sizeof(json), millis());
+    if (n) ws.textAll(json, n);
+}
+
+void publishTaskProfile() {
+    if (ws.count() == 0) return;
+
+    static char json[TASK_PROFILER_JSON_SIZE];  // loop() only
+    size_t n = profiler_sample(json, sizeof(json));
+    if (n) ws.textAll(json, n);
+    else LOG("[WARN] Task profile doesn't fit TASK_PROFILER_JSON_SIZE");
+}
+
+// ✅ One /fit download: the ride file and the encoder streaming it, freed with the response
+struct FitDownload {
+    File file;
+    FitEncoder encoder;
+};
+
+// ✅ GET /fit?ride=<name>: the ride as a FIT activity, encoded chunk by chunk as the TCP
+// window opens. The FIT header comes from the ride's summary, so this normally reads
+// no more than the summary slot.
+static void sendFit(AsyncWebServerRequest *request) {
+    const AsyncWebParameter *ride = request->getParam("ride");
+    char path[32];
+    if (!ride || !ride_path(path, sizeof(path), ride->value().c_str())) {
+        request->send(400, "text/plain", "Usage: /fit?ride=<name from /rides>");
+        return;
+    }
+
+    std::shared_ptr<FitDownload> download(new (std::nothrow) FitDownload());
+    if (!download) {
+        request->send(503, "text/plain", "Out of memory");
+        return;
+    }
+    download->file = LittleFS.open(path, "r");
+    RideSummary summary;
+    if (!download->file || !ride_get_summary(download->file, ride->value().c_str(), summary) ||
+        !download->encoder.begin(ride_read_file, &download->file, summary)) {
+        request->send(404, "text/plain", "No such ride, or nothing recorded in it");
+        return;
+    }
+    LOGF("[INFO] FIT export of %s: %u samples, %u bytes", path, download->encoder.getSamples(),
+         download->encoder.getFileBytes());
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+        "application/vnd.ant.fit", [download](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            size_t n = download->encoder.read(buffer, maxLen);  // 0 ends the response
+            if (n == 0 && download->encoder.getPaddedRecords()) {
+                LOGF("[WARN] FIT export: %u unreadable samples repeated the last record",
+                     (unsigned)download->encoder.getPaddedRecords());
+            }
+            return n;
+        });
+    char disposition[48];
+    int digits = strlen(ride->value().c_str()) - strlen(RIDE_EXTENSION);
+    snprintf(disposition, sizeof(disposition), "attachment; filename=\"%.*s.fit\"", digits, ride->value().c_str());
+    response->addHeader("Content-Disposition", disposition);
+    request->send(response);
 }
 
 void startWebSocketServer() {
     ws.onEvent([](AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
         if (type == WS_EVT_DATA) {
-            onWebSocketMessage(arg, data, len);
+            onWebSocketMessage(client, arg, data, len);
+        } else if (type == WS_EVT_DISCONNECT) {
+            telemetry_client_subscribe(client->id(), false);
+            wsIngest.disconnected(client->id());
         }
     });
 
     server.addHandler(&ws);
+
+    // ✅ Flight recorder segments (capture_recorder.h): list, then download by name.
+    // Static handlers go first: a route also matches the paths below it.
+    server.serveStatic("/capture/", LittleFS, CAPTURE_DIR "/");
+    server.on("/capture", HTTP_GET, [](AsyncWebServerRequest *request) {
+        static char json[CAPTURE_LIST_JSON_SIZE];  // async_tcp task only
+        size_t n = capture_list_json(json, sizeof(json));
+        if (n) request->send(200, "application/json", json);
+        else request->send(500, "text/plain", "Capture list too long");
+    });
+
+    // ✅ Recorded rides (ride_recorder.h), same scheme; /fit converts one to FIT on the fly
+    server.serveStatic("/rides/", LittleFS, RIDE_DIR "/");
+    server.on("/rides", HTTP_GET, [](AsyncWebServerRequest *request) {
+        static char json[RIDE_LIST_JSON_SIZE];  // async_tcp task only
+        size_t n = ride_list_json(json, sizeof(json));
+        if (n) request->send(200, "application/json", json);
+        else request->send(500, "text/plain", "Ride list too long");
+    });
+    server.on("/fit", HTTP_GET, sendFit);
+
     server.begin();
-    Serial.println("WebSocket Server Started!");
+    LOG("✅ WebSocket Server Started!");
 }
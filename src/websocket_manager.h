@@ -8,6 +8,8 @@
 extern AsyncWebSocket ws;
 
 void startWebSocketServer();
-void onWebSocketMessage(void *arg, uint8_t *data, size_t len);
+void onWebSocketMessage(AsyncWebSocketClient *client, void *arg, uint8_t *data, size_t len);
+void publishMetricsSnapshot();  // ✅ JSON metrics to every connected client
+void publishTaskProfile();  // ✅ Per-task CPU/stack snapshot (profiling mode) to every client
 
 #endif // WEBSOCKET_MANAGER_H
@@ -1,11 +1,11 @@
 #include <WiFi.h>
+#include "wifi_manager.h"
 #include "logger.h"
 #include "led_service.h"
+#include "metrics.h"
 
 #define WIFI_SSID "ESP32Network"  
 #define WIFI_PASS "MySecretPassword"  
-#define WIFI_TIMEOUT_MS 20000     
-#define WIFI_RETRY_DELAY_MS 1000   
 
 // ✅ Define a static IP configuration
 IPAddress local_IP(192, 168, 4, 10);  // Fixed IP for ESP32
@@ -14,46 +14,93 @@ IPAddress subnet(255, 255, 255, 0);
 IPAddress primaryDNS(8, 8, 8, 8);
 IPAddress secondaryDNS(8, 8, 4, 4);
 
-void wifi_init() {
-    LOG("🔍 Connecting to WiFi...");
-    led_set_flashing(500);  
+enum class WiFiState : uint8_t {
+    Connecting,  // WiFi.begin() issued, waiting for an IP or a disconnect
+    Waiting,     // Backing off before the next attempt
+    Connected
+};
+
+static volatile WiFiState state = WiFiState::Waiting;
+static volatile bool attemptFailed = false;  // Set by the event task, handled by wifi_update()
+static uint32_t attemptStartMs = 0;
+static uint32_t nextAttemptMs = 0;
+static uint32_t backoffMs = WIFI_BACKOFF_MIN_MS;
 
-    WiFi.disconnect(true, true);  // Forget old connection
-    delay(1000);
+// ✅ Runs on the Arduino event task: only records what happened
+static void onWiFiEvent(WiFiEvent_t event, WiFiEventInfo_t info) {
+    switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+            state = WiFiState::Connected;
+            attemptFailed = false;  // Events arrive in order: whatever failed before, we're up now
+            metrics.markBoot(BOOT_WIFI);
+            break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+            LOGF("[WARN] WiFi disconnected, reason %d", info.wifi_sta_disconnected.reason);
+            attemptFailed = true;
+            break;
+        default:
+            break;
+    }
+}
+
+static void beginAttempt(uint32_t nowMs) {
+    LOG("🔍 Connecting to WiFi...");
+    led_set_flashing(500);
+    state = WiFiState::Connecting;
+    attemptFailed = false;
+    attemptStartMs = nowMs;
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+}
 
+void wifi_start() {
+    WiFi.onEvent(onWiFiEvent);
     WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false);  // ✅ Retries follow our backoff, not the driver's
 
     // ✅ Apply static IP configuration before connecting
     if (!WiFi.config(local_IP, gateway, subnet, primaryDNS, secondaryDNS)) {
         LOG("❌ Failed to configure static IP!");
     }
 
-    WiFi.begin(WIFI_SSID, WIFI_PASS);
-
-    unsigned long startAttemptTime = millis();
+    beginAttempt(millis());
+}
 
-    while (WiFi.status() != WL_CONNECTED) {
-        LOGF("WiFi Status: %d", WiFi.status());
+void wifi_update(uint32_t nowMs) {
+    static bool reportedConnected = false;
+    static bool sntpStarted = false;
 
-        if (WiFi.status() == WL_DISCONNECTED) {
-            LOG("🔄 Disconnected! Restarting Wi-Fi...");
-            WiFi.disconnect(true, true);
-            delay(1000);
-            WiFi.begin(WIFI_SSID, WIFI_PASS);
-            startAttemptTime = millis();
+    if (state == WiFiState::Connected && !attemptFailed) {
+        if (!reportedConnected) {
+            LOGF("✅ Connected! IP Address: %s", WiFi.localIP().toString().c_str());
+            led_set_solid(5000);
+            backoffMs = WIFI_BACKOFF_MIN_MS;
+            reportedConnected = true;
+            if (!sntpStarted) {
+                configTime(0, 0, WIFI_NTP_SERVER);  // ✅ UTC wall clock for ride timestamps; SNTP keeps it synced
+                sntpStarted = true;
+            }
         }
+        return;
+    }
 
-        if (millis() - startAttemptTime > WIFI_TIMEOUT_MS) {
-            LOG("\n❌ WiFi connection timeout! Restarting...");
-            ESP.restart();
-        }
+    if (state != WiFiState::Waiting) {
+        bool timedOut = state == WiFiState::Connecting && nowMs - attemptStartMs > WIFI_CONNECT_TIMEOUT_MS;
+        if (!attemptFailed && !timedOut) return;
 
-        delay(WIFI_RETRY_DELAY_MS);
-        LOG(".");
+        // ✅ Lost the link or the attempt failed: wait, doubling up to the cap
+        reportedConnected = false;
+        WiFi.disconnect();
+        state = WiFiState::Waiting;
+        attemptFailed = false;
+        nextAttemptMs = nowMs + backoffMs;
+        LOGF("[WARN] WiFi not connected, retrying in %u ms", backoffMs);
+        backoffMs = backoffMs * 2 > WIFI_BACKOFF_MAX_MS ? WIFI_BACKOFF_MAX_MS : backoffMs * 2;
+        return;
     }
 
-    LOG("\n✅ Connected! IP Address: ");
-    LOG(WiFi.localIP());
+    if ((int32_t)(nowMs - nextAttemptMs) >= 0) beginAttempt(nowMs);
+}
 
-    led_set_solid(5000);  
+bool wifi_is_connected() {
+    return state == WiFiState::Connected && WiFi.status() == WL_CONNECTED;
 }
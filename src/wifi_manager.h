@@ -8,6 +8,16 @@
 #include "nvs_flash.h"
 #include "Arduino.h"
 
+#define WIFI_BACKOFF_MIN_MS 1000
+#define WIFI_BACKOFF_MAX_MS 60000
+#define WIFI_CONNECT_TIMEOUT_MS 15000  // An attempt with no IP by then counts as failed
+#define WIFI_NTP_SERVER "pool.ntp.org"
+
+// ✅ Event-driven station manager. wifi_start() returns at once; WiFi events track the
+// link, and wifi_update() (from loop()) retries with exponential backoff. It never
+// blocks and never restarts the chip: BLE keeps working with no access point around.
+void wifi_start();
+void wifi_update(uint32_t nowMs);
+bool wifi_is_connected();
 
-void wifi_init();
 #endif  // WIFI_MANAGER_H